@@ -2,8 +2,15 @@
 #include "PlateDB.h"
 #include "data.h"
 #include "stdlib.h"
+#include <fcntl.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char PlateDBMagic[8] = "PLATEDB";
+static const uint32_t PlateDBVersion = 3;
 
 // A function to get the number of lines in a file
 int GetFileLines(char *FileName) {
@@ -64,6 +71,105 @@ Car ReadLine(char line[10]) {
   return car;
 }
 
+// A function to scan one line into a Car struct without sscanf
+// Works like ReadLine, but the line does not have to be null terminated
+// Returns 0 if the line holds no plate (e.g. a blank line)
+static int ScanLine(const char *line, const char *end, Car *car) {
+  const char *c = line;
+
+  // Skipping leading whitespace
+  while (c < end && (*c == ' ' || *c == '\t' || *c == '\r')) c++;
+
+  // Copying the plate; plates longer than 7 characters are cut off
+  int length = 0;
+  while (c < end && *c != ' ' && *c != '\t' && *c != '\r') {
+    if (length < 7) car->plate[length++] = *c;
+    c++;
+  }
+  car->plate[length] = '\0';
+  if (length == 0) {
+    return 0;
+  }
+
+  // Skipping whitespace between the plate and the type
+  while (c < end && (*c == ' ' || *c == '\t')) c++;
+
+  // Reading the type as a (possibly negative) whole number
+  int sign = 1;
+  if (c < end && *c == '-') {
+    sign = -1;
+    c++;
+  }
+  int num = 0;
+  while (c < end && *c >= '0' && *c <= '9') {
+    num = num * 10 + (*c - '0');
+    c++;
+  }
+  car->type = (SpaceType)(sign * num);
+  return 1;
+}
+
+// A function to read the whole file into a new Car array in a single pass
+// The array grows as needed and its final size is written to size
+Car *LoadPlateDB(char *FileName, int *size) {
+  // Opening file from name
+  FILE *fptr = fopen(FileName, "rb");
+  if (fptr == NULL) {
+    printf("ERROR: Cant open file %s!\n", FileName);
+    exit(1);
+  }
+
+  int capacity = 1024;
+  int count = 0;
+  Car *CarArr = malloc(sizeof(Car) * capacity);
+
+  // Reading the file in big chunks; a line cut off at the end of a chunk
+  // is moved to the front of the buffer and finished by the next chunk
+  char buffer[1 << 16];
+  size_t filled = 0;
+  int done = 0;
+  while (!done) {
+    size_t got = fread(buffer + filled, 1, sizeof(buffer) - filled, fptr);
+    filled += got;
+    done = got == 0;
+
+    const char *line = buffer;
+    const char *end = buffer + filled;
+    while (line < end) {
+      const char *newline = memchr(line, '\n', end - line);
+      if (!newline) {
+        int buffer_full = line == buffer && filled == sizeof(buffer);
+        if (!done && !buffer_full) break; // unfinished line, wait for the next chunk
+        newline = end; // last line without a newline (or a line longer than the whole buffer)
+      }
+
+      // Growing the array geometrically so loading stays linear
+      if (count == capacity) {
+        capacity *= 2;
+        Car *grown = realloc(CarArr, sizeof(Car) * capacity);
+        if (!grown) {
+          printf("ERROR: Memory reallocation failed!\n");
+          exit(1);
+        }
+        CarArr = grown;
+      }
+      if (ScanLine(line, newline, &CarArr[count])) {
+        count++;
+      }
+      line = newline < end ? newline + 1 : end;
+    }
+
+    // Moving the unfinished line to the front
+    filled = end - line;
+    memmove(buffer, line, filled);
+  }
+
+  // Closing file again
+  fclose(fptr);
+  *size = count;
+  return CarArr;
+}
+
 // A function to find the index of a given plate in the a Car array
 int GetCarIndexFromPlate(Car *CarArr, int size, char plate[8]) {
   for (int i = 0; i < size; i++) {
@@ -77,3 +183,241 @@ int GetCarIndexFromPlate(Car *CarArr, int size, char plate[8]) {
   // retuning -1 if plate is not found
   return -1;
 }
+
+// A function to pack a plate into a single integer key
+// Plates are at most 7 characters, so every character gets its own byte
+// Two plates get the same key only if they are the same string
+uint64_t PackPlate(const char *plate) {
+  uint64_t key = 0;
+  for (int i = 0; i < 7 && plate[i] != '\0'; i++) {
+    key |= (uint64_t)(unsigned char)plate[i] << (8 * i);
+  }
+  return key;
+}
+
+// A function to find the first slot of a key (Fibonacci hashing)
+static int PlateSlot(uint64_t key, int SlotCount) {
+  return (int)((key * 0x9E3779B97F4A7C15ULL) >> 32) & (SlotCount - 1);
+}
+
+// A function to build the hash index of a Car array
+PlateIndex BuildPlateIndex(Car *CarArr, int size) {
+  PlateIndex index;
+
+  // Keeping the table at most half full so lookups stay short
+  index.SlotCount = 1;
+  while (index.SlotCount < 2 * size) {
+    index.SlotCount <<= 1;
+  }
+  index.Keys = calloc(index.SlotCount, sizeof(uint64_t));
+  index.Indices = malloc(sizeof(int) * index.SlotCount);
+  for (int slot = 0; slot < index.SlotCount; slot++) {
+    index.Indices[slot] = -1;
+  }
+
+  for (int i = 0; i < size; i++) {
+    uint64_t key = PackPlate(CarArr[i].plate);
+    if (key == 0) {
+      continue; // Empty plates can never be looked up
+    }
+    int slot = PlateSlot(key, index.SlotCount);
+    // Linear probing until we find the plate or an empty slot
+    while (index.Keys[slot] != 0 && index.Keys[slot] != key) {
+      slot = (slot + 1) & (index.SlotCount - 1);
+    }
+    // Only the first car with a plate is kept, just like the linear search
+    if (index.Keys[slot] == 0) {
+      index.Keys[slot] = key;
+      index.Indices[slot] = i;
+    }
+  }
+  return index;
+}
+
+// A function to free the hash index again
+void FreePlateIndex(PlateIndex index) {
+  free(index.Keys);
+  free(index.Indices);
+}
+
+// A function to find the index of a given plate using the hash index
+// Gives up after looking at every slot once, so a full (corrupt) index still ends
+int GetCarIndexFromPlateIndex(const PlateIndex *index, const char *plate) {
+  uint64_t key = PackPlate(plate);
+  if (key == 0 || index->SlotCount == 0) {
+    return -1;
+  }
+  int slot = PlateSlot(key, index->SlotCount);
+  for (int steps = 0; steps < index->SlotCount && index->Keys[slot] != 0; steps++) {
+    if (index->Keys[slot] == key) {
+      return index->Indices[slot];
+    }
+    slot = (slot + 1) & (index->SlotCount - 1);
+  }
+  // retuning -1 if plate is not found
+  return -1;
+}
+
+// A function to turn a packed key back into a Car struct
+Car UnpackPlate(uint64_t key, SpaceType type) {
+  Car car;
+  for (int i = 0; i < 7; i++) {
+    car.plate[i] = (char)((key >> (8 * i)) & 0xFF);
+  }
+  car.plate[7] = '\0';
+  car.type = type;
+  return car;
+}
+
+// Rounds a byte offset up to the next multiple of 8 so 64 bit arrays stay aligned
+static size_t AlignTo8(size_t offset) {
+  return (offset + 7) & ~(size_t)7;
+}
+
+// A function to get the size and modification time of a file
+// Returns 1 on success and 0 if the file cannot be looked at
+static int GetSourceStamp(char *FileName, uint64_t *Size, int64_t *MTime) {
+  struct stat info;
+  if (FileName == NULL || stat(FileName, &info) != 0) {
+    return 0;
+  }
+  *Size = (uint64_t)info.st_size;
+  *MTime = (int64_t)info.st_mtime;
+  return 1;
+}
+
+// A function to write a Car array as a compiled PlateDB file
+// SourceFileName is the text file the cars were read from (or NULL), so opening can tell when it has changed
+// Returns 0 on success and 1 if the file could not be written
+int WritePlateDBBinary(Car *CarArr, int size, char *SourceFileName, char *FileName) {
+  FILE *fptr = fopen(FileName, "wb");
+  if (fptr == NULL) {
+    printf("ERROR: Cant open file %s!\n", FileName);
+    return 1;
+  }
+
+  PlateIndex index = BuildPlateIndex(CarArr, size);
+  PlateDBHeader header = {0};
+  memcpy(header.Magic, PlateDBMagic, sizeof(header.Magic));
+  header.Version = PlateDBVersion;
+  header.CarCount = (uint32_t)size;
+  header.SlotCount = (uint32_t)index.SlotCount;
+  GetSourceStamp(SourceFileName, &header.SourceSize, &header.SourceMTime);
+
+  uint64_t *Keys = malloc(sizeof(uint64_t) * (size + 1));
+  uint8_t *Types = calloc(AlignTo8(size) + 1, sizeof(uint8_t));
+  for (int i = 0; i < size; i++) {
+    Keys[i] = PackPlate(CarArr[i].plate);
+    Types[i] = (uint8_t)CarArr[i].type;
+  }
+
+  int failed = fwrite(&header, sizeof(header), 1, fptr) != 1;
+  failed |= fwrite(Keys, sizeof(uint64_t), size, fptr) != (size_t)size;
+  failed |= fwrite(Types, 1, AlignTo8(size), fptr) != AlignTo8(size);
+  failed |= fwrite(index.Keys, sizeof(uint64_t), index.SlotCount, fptr) != (size_t)index.SlotCount;
+  failed |= fwrite(index.Indices, sizeof(int32_t), index.SlotCount, fptr) != (size_t)index.SlotCount;
+  failed |= fclose(fptr) != 0;
+
+  free(Keys);
+  free(Types);
+  FreePlateIndex(index);
+  if (failed) {
+    printf("ERROR: Failed to write %s!\n", FileName);
+  }
+  return failed;
+}
+
+// A function to compile a text PlateDB into a binary one
+int ConvertPlateDB(char *TextFileName, char *BinaryFileName) {
+  int size = 0;
+  Car *CarArr = LoadPlateDB(TextFileName, &size);
+  int result = WritePlateDBBinary(CarArr, size, TextFileName, BinaryFileName);
+  free(CarArr);
+  return result;
+}
+
+// A function to map a compiled PlateDB into memory
+// Nothing is parsed or copied, so this takes the same time for any number of plates
+// If SourceFileName is given and has changed since the PlateDB was compiled from it, the PlateDB is refused;
+// a text file that cannot be found is nothing to be out of date with
+// Returns 0 on success and 1 if the file is missing, out of date or not a valid PlateDB
+int OpenPlateDBBinary(char *FileName, char *SourceFileName, MappedPlateDB *db) {
+  memset(db, 0, sizeof(*db));
+  int fd = open(FileName, O_RDONLY);
+  if (fd < 0) {
+    return 1;
+  }
+
+  struct stat info;
+  if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(PlateDBHeader)) {
+    close(fd);
+    return 1;
+  }
+  void *map = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd); // the mapping stays valid after closing
+  if (map == MAP_FAILED) {
+    return 1;
+  }
+
+  // Checking the header before trusting any of the sizes in it
+  const PlateDBHeader *header = map;
+  size_t CarCount = header->CarCount;
+  size_t SlotCount = header->SlotCount;
+  size_t TypesOffset = sizeof(PlateDBHeader) + sizeof(uint64_t) * CarCount;
+  size_t SlotKeysOffset = TypesOffset + AlignTo8(CarCount);
+  size_t SlotIndicesOffset = SlotKeysOffset + sizeof(uint64_t) * SlotCount;
+  size_t expected = SlotIndicesOffset + sizeof(int32_t) * SlotCount;
+  int PowerOfTwo = SlotCount > 0 && SlotCount <= (1u << 30) && (SlotCount & (SlotCount - 1)) == 0;
+  if (memcmp(header->Magic, PlateDBMagic, sizeof(header->Magic)) != 0 ||
+      header->Version != PlateDBVersion || !PowerOfTwo || (size_t)info.st_size != expected) {
+    munmap(map, info.st_size);
+    return 1;
+  }
+  uint64_t SourceSize;
+  int64_t SourceMTime;
+  if (GetSourceStamp(SourceFileName, &SourceSize, &SourceMTime) &&
+      (SourceSize != header->SourceSize || SourceMTime != header->SourceMTime)) {
+    munmap(map, info.st_size);
+    return 1;
+  }
+
+  const char *bytes = map;
+  db->Map = map;
+  db->MapSize = info.st_size;
+  db->CarCount = (int)CarCount;
+  db->Keys = (const uint64_t *)(bytes + sizeof(PlateDBHeader));
+  db->Types = (const uint8_t *)(bytes + TypesOffset);
+  // The index is only ever read, so it can point straight into the read-only mapping
+  db->Index.Keys = (uint64_t *)(bytes + SlotKeysOffset);
+  db->Index.Indices = (int *)(bytes + SlotIndicesOffset);
+  db->Index.SlotCount = (int)SlotCount;
+  return 0;
+}
+
+// A function to unmap a compiled PlateDB again
+void ClosePlateDBBinary(MappedPlateDB db) {
+  if (db.Map) {
+    munmap(db.Map, db.MapSize);
+  }
+}
+
+// A function to find the index of a given plate in a compiled PlateDB
+// Gives the same index as GetCarIndexFromPlate on the original Car array
+// The index comes straight from the file, so a slot is only trusted if it points at a car with that plate;
+// checking here instead of when opening keeps opening just as fast for any number of plates
+int GetCarIndexFromMappedPlateDB(const MappedPlateDB *db, const char *plate) {
+  int index = GetCarIndexFromPlateIndex(&db->Index, plate);
+  if (index < 0 || index >= db->CarCount || db->Keys[index] != PackPlate(plate)) {
+    return -1;
+  }
+  return index;
+}
+
+// A function to get a Car struct out of a compiled PlateDB
+// An index that is not a car gives a car with an empty plate
+Car GetCarFromMappedPlateDB(const MappedPlateDB *db, int index) {
+  if (index < 0 || index >= db->CarCount) {
+    return UnpackPlate(0, Standard);
+  }
+  return UnpackPlate(db->Keys[index], (SpaceType)db->Types[index]);
+}
@@ -1,8 +1,55 @@
 #pragma once
 #include <data.h>
+#include <stddef.h>
+#include <stdint.h>
 // #include <stdio.h>
 
+// Open addressing hash table from a packed plate to its index in the Car array
+typedef struct {
+  uint64_t *Keys; // packed plate in each slot, 0 if the slot is empty
+  int *Indices;   // index in the Car array for each slot
+  int SlotCount;  // always a power of two
+} PlateIndex;
+
+// Header of a compiled (binary) PlateDB file
+// The file is laid out as: header, packed plate keys, SpaceTypes (padded to
+// 8 bytes), slot keys and slot indices of a prebuilt PlateIndex.
+// Everything is stored in the byte order of the machine that compiled it.
+// The size and modification time of the text file it was compiled from are kept,
+// so a compiled PlateDB that is older than its text file is not used.
+typedef struct {
+  char Magic[8];      // "PLATEDB" followed by a null byte
+  uint32_t Version;
+  uint32_t CarCount;
+  uint32_t SlotCount;
+  uint32_t Reserved;
+  uint64_t SourceSize;  // 0 with SourceMTime 0 if it was not compiled from a file
+  int64_t SourceMTime;
+} PlateDBHeader;
+
+// A compiled PlateDB mapped into memory
+typedef struct {
+  void *Map;
+  size_t MapSize;
+  int CarCount;
+  const uint64_t *Keys;  // packed plate of every car
+  const uint8_t *Types;  // SpaceType of every car
+  PlateIndex Index;      // points into the mapping, so it must never be freed
+} MappedPlateDB;
+
 Car ReadLine(char line[10]);
 int GetFileLines(char *FileName);
 void ReadFile(Car *CarArr, int lines, char *FileName);
+Car *LoadPlateDB(char *FileName, int *size);
 int GetCarIndexFromPlate(Car *CarArr, int size, char plate[8]);
+uint64_t PackPlate(const char *plate);
+PlateIndex BuildPlateIndex(Car *CarArr, int size);
+void FreePlateIndex(PlateIndex index);
+int GetCarIndexFromPlateIndex(const PlateIndex *index, const char *plate);
+Car UnpackPlate(uint64_t key, SpaceType type);
+int WritePlateDBBinary(Car *CarArr, int size, char *SourceFileName, char *FileName);
+int ConvertPlateDB(char *TextFileName, char *BinaryFileName);
+int OpenPlateDBBinary(char *FileName, char *SourceFileName, MappedPlateDB *db);
+void ClosePlateDBBinary(MappedPlateDB db);
+int GetCarIndexFromMappedPlateDB(const MappedPlateDB *db, const char *plate);
+Car GetCarFromMappedPlateDB(const MappedPlateDB *db, int index);
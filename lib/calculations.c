@@ -3,6 +3,12 @@
 #include "calculations.h"
 #include "data.h"
 
+// the batched SAT kernel below has an AVX2 version on x86-64 when the compiler can build it
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define HAVE_AVX2_KERNEL 1
+#endif
+
 // === Vector operations useful to handle space data ===
 
 Vector subtract_vectors(Vector a, Vector b) {
@@ -112,3 +118,98 @@ int separating_axis(Rectangle rect1, Rectangle rect2) {
   
   return 0;  // no separating axis found, they overlap :(
 }
+
+// === Batched separating axis test ===
+
+#ifdef HAVE_AVX2_KERNEL
+// projects two sets of 4 rectangles (one rectangle per lane) onto one axis per lane and
+// returns a lane mask of the ones whose projections do not overlap.
+// every step is the same double math as project_onto_axis, rounded to float the same way,
+// so the answer is exactly the one separating_axis gives.
+__attribute__((target("avx2")))
+static __m128 axis_separates_avx2(const __m256d *ax, const __m256d *ay, const __m256d *bx, const __m256d *by,
+                                  __m256d axis_x, __m256d axis_y) {
+  __m128 min1 = _mm_set1_ps(FLT_MAX), max1 = _mm_set1_ps(-FLT_MAX);
+  __m128 min2 = _mm_set1_ps(FLT_MAX), max2 = _mm_set1_ps(-FLT_MAX);
+  for (int c = 0; c < 4; c++) {
+    __m128 p1 = _mm256_cvtpd_ps(_mm256_add_pd(_mm256_mul_pd(ax[c], axis_x), _mm256_mul_pd(ay[c], axis_y)));
+    __m128 p2 = _mm256_cvtpd_ps(_mm256_add_pd(_mm256_mul_pd(bx[c], axis_x), _mm256_mul_pd(by[c], axis_y)));
+    min1 = _mm_min_ps(min1, p1);
+    max1 = _mm_max_ps(max1, p1);
+    min2 = _mm_min_ps(min2, p2);
+    max2 = _mm_max_ps(max2, p2);
+  }
+  // the inverse of projections_overlap
+  return _mm_or_ps(_mm_cmplt_ps(max1, min2), _mm_cmplt_ps(max2, min1));
+}
+
+// tests rect against 4 rectangles at a time, one per lane of the double vectors
+__attribute__((target("avx2")))
+static void separating_axis_batch_avx2(Rectangle rect, const Rectangle *others, int count, int *out_separated) {
+  const __m256d sign = _mm256_set1_pd(-0.0);
+  __m256d rx[4], ry[4];
+  for (int c = 0; c < 4; c++) {
+    rx[c] = _mm256_set1_pd(rect.corner[c].x);
+    ry[c] = _mm256_set1_pd(rect.corner[c].y);
+  }
+
+  int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m256d ox[4], oy[4];
+    for (int c = 0; c < 4; c++) {
+      ox[c] = _mm256_set_pd(others[i + 3].corner[c].x, others[i + 2].corner[c].x, others[i + 1].corner[c].x, others[i].corner[c].x);
+      oy[c] = _mm256_set_pd(others[i + 3].corner[c].y, others[i + 2].corner[c].y, others[i + 1].corner[c].y, others[i].corner[c].y);
+    }
+
+    __m128 separated = _mm_setzero_ps();
+    for (int e = 0; e < 2; e++) {
+      // the axes of rect are the same in every lane, the axes of the others differ per lane
+      // the axis is normal_vector(edge), ie (-edge.y, edge.x)
+      __m256d edge_x = _mm256_sub_pd(rx[e + 1], rx[e]);
+      __m256d edge_y = _mm256_sub_pd(ry[e + 1], ry[e]);
+      separated = _mm_or_ps(separated, axis_separates_avx2(rx, ry, ox, oy, _mm256_xor_pd(edge_y, sign), edge_x));
+
+      edge_x = _mm256_sub_pd(ox[e + 1], ox[e]);
+      edge_y = _mm256_sub_pd(oy[e + 1], oy[e]);
+      separated = _mm_or_ps(separated, axis_separates_avx2(rx, ry, ox, oy, _mm256_xor_pd(edge_y, sign), edge_x));
+    }
+
+    int mask = _mm_movemask_ps(separated);
+    for (int k = 0; k < 4; k++) {
+      out_separated[i + k] = (mask >> k) & 1;
+    }
+  }
+
+  // the last few go through the scalar test
+  for (; i < count; i++) {
+    out_separated[i] = separating_axis(rect, others[i]);
+  }
+}
+
+// asks the cpu directly every time, which is just a lookup and keeps this safe to call from any thread
+static int avx2_supported(void) {
+  return __builtin_cpu_supports("avx2");
+}
+#endif
+
+// separating_axis of one rectangle against many
+// out_separated[k] is set to separating_axis(rect, others[k]); returns how many of the others overlap rect
+// uses AVX2 when the cpu has it and falls back to the scalar test otherwise
+int separating_axis_batch(Rectangle rect, const Rectangle *others, int count, int *out_separated) {
+#ifdef HAVE_AVX2_KERNEL
+  if (avx2_supported()) {
+    separating_axis_batch_avx2(rect, others, count, out_separated);
+  } else
+#endif
+  {
+    for (int i = 0; i < count; i++) {
+      out_separated[i] = separating_axis(rect, others[i]);
+    }
+  }
+
+  int overlapping = 0;
+  for (int i = 0; i < count; i++) {
+    overlapping += !out_separated[i];
+  }
+  return overlapping;
+}
@@ -14,3 +14,4 @@ double cross_product_2d(Vector a, Vector b);
 double degrees_to_radians(double degrees);
 
 int separating_axis(Rectangle rect1, Rectangle rect2);
+int separating_axis_batch(Rectangle rect, const Rectangle *others, int count, int *out_separated);
@@ -1,6 +1,11 @@
 #include "data.h"
 #include "calculations.h"
 #include <float.h>
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 // Calculate the endpoint of the path based on its start_point and vector
 Location get_endpoint(const Path path) {
@@ -13,6 +18,21 @@ Location get_endpoint(const Path path) {
   
 // given a lot and a CarIndex, return the index of the space occupied by that car, or -1 if not found
 int get_occupied_space_from_car(Lot lot, int CarIndex) {
+  // loaded lots keep a reverse index, so no scan is needed
+  if (lot.parked) {
+    if (CarIndex < 0 || CarIndex >= lot.parked->capacity) {
+      return -1; // this car has never been parked
+    }
+    return lot.parked->space_of[CarIndex];
+  }
+  if (lot.columns) {
+    const int *occupied = lot.columns->occupied;
+    for (int i = 0; i < lot.columns->count; i++) {
+      if (occupied[i] == CarIndex) return i;
+    }
+    return -1;
+  }
+
   for (int i = 0; i < lot.space_count; i++) {
     if (lot.spaces[i].occupied == CarIndex) {
       return i; // Return the index of the occupied space
@@ -57,11 +77,18 @@ Rectangle get_space_rectangle(const Space space) {
       {0, dim.height} // self-explanatory
   };
 
+  // every corner is rotated by the same angle, so cos and sin are only needed once
+  double cos_angle = cos(angle_rad);
+  double sin_angle = sin(angle_rad);
+
   Rectangle rect;
   for (int i = 0; i < 4; i++) {
     // since each "corner" is really a vector from the bottom left to corner i,
-    // we can just rotate this vector.
-    Vector rotated = rotate_vector(local_corners[i], angle_rad);
+    // we can just rotate this vector (same math as rotate_vector).
+    Vector rotated = {
+      local_corners[i].x * cos_angle - local_corners[i].y * sin_angle,
+      local_corners[i].x * sin_angle + local_corners[i].y * cos_angle
+    };
     // then we use simple vector math to find the vector from the origin to the corner in world space, ie a coordinate.
     rect.corner[i].x = rotated.x + space.location.x;
     rect.corner[i].y = rotated.y + space.location.y;
@@ -71,6 +98,192 @@ Rectangle get_space_rectangle(const Space space) {
                // space given.
 }
 
+// the rectangle of a space along with its bounding box and entry point
+SpaceGeometry get_space_geometry(const Space space) {
+  SpaceGeometry geometry;
+  geometry.rect = get_space_rectangle(space);
+  geometry.min = geometry.max = geometry.rect.corner[0];
+  for (int i = 1; i < 4; i++) {
+    if (geometry.rect.corner[i].x < geometry.min.x) geometry.min.x = geometry.rect.corner[i].x;
+    if (geometry.rect.corner[i].y < geometry.min.y) geometry.min.y = geometry.rect.corner[i].y;
+    if (geometry.rect.corner[i].x > geometry.max.x) geometry.max.x = geometry.rect.corner[i].x;
+    if (geometry.rect.corner[i].y > geometry.max.y) geometry.max.y = geometry.rect.corner[i].y;
+  }
+  geometry.entry = (Vector){
+    (geometry.rect.corner[0].x + geometry.rect.corner[1].x) / 2.0,
+    (geometry.rect.corner[0].y + geometry.rect.corner[1].y) / 2.0
+  };
+  return geometry;
+}
+
+// compute the geometry of every space once, so nothing has to redo the trig later
+SpaceGeometry *build_space_geometry(const Lot lot) {
+  SpaceGeometry *geometry = malloc(sizeof(SpaceGeometry) * (lot.space_count + 1));
+  for (int i = 0; i < lot.space_count; i++) {
+    geometry[i] = get_space_geometry(lot.spaces[i]);
+  }
+  return geometry;
+}
+
+// geometry of a space in the lot; cached if the lot has it, computed otherwise
+SpaceGeometry lot_space_geometry(const Lot lot, int space_index) {
+  if (lot.geometry) return lot.geometry[space_index];
+  return get_space_geometry(lot.spaces[space_index]);
+}
+
+Rectangle lot_space_rectangle(const Lot lot, int space_index) {
+  if (lot.geometry) return lot.geometry[space_index].rect;
+  return get_space_rectangle(lot.spaces[space_index]);
+}
+
 int compare_locations(Location loc1, Location loc2) {
     return (loc1.x == loc2.x) && (loc1.y == loc2.y) && (loc1.level == loc2.level);
 }
+
+// 64 bit FNV-1a hash of a space name, for the tables that look spaces up by name
+uint64_t hash_name(const char *name) {
+  uint64_t h = 0xcbf29ce484222325ULL;
+  for (; *name; name++) {
+    h ^= (unsigned char)*name;
+    h *= 0x100000001b3ULL;
+  }
+  return h;
+}
+
+// === Level table ===
+
+// the level of the i-th thing in the lot, counting spaces, then paths, then ups, then downs
+static int item_level(const Lot lot, int i) {
+  if (i < lot.space_count) return lot.spaces[i].location.level;
+  i -= lot.space_count;
+  if (i < lot.path_count) return lot.paths[i].start_point.level;
+  i -= lot.path_count;
+  if (i < lot.up_count) return lot.ups[i].level;
+  return lot.downs[i - lot.up_count].level;
+}
+
+// the lowest and highest level anything is on; returns 0 for a lot with nothing on it
+static int level_range(const Lot lot, int *out_min, int *out_max) {
+  int found = 0;
+  int item_count = lot.space_count + lot.path_count + lot.up_count + lot.down_count;
+  for (int i = 0; i < item_count; i++) {
+    int level = item_level(lot, i);
+    if (!found || level < *out_min) *out_min = level;
+    if (!found || level > *out_max) *out_max = level;
+    found = 1;
+  }
+  return found;
+}
+
+// a lot can't have more levels than things to put on them, so levels further apart than that are a typo
+// sets out_min_level and out_max_level to the lowest and highest level and returns 1 if so, else returns 0
+int level_span_out_of_range(const Lot lot, int *out_min_level, int *out_max_level) {
+  int item_count = lot.space_count + lot.path_count + lot.up_count + lot.down_count;
+  if (!level_range(lot, out_min_level, out_max_level)) return 0;
+  return (long long)*out_max_level - *out_min_level + 1 > item_count;
+}
+
+// go over every space, path, up and down and note what is on each level
+// the table is dense from the lowest level to the highest, so the loaders refuse far apart levels
+// (see level_span_out_of_range) before they get here
+LevelTable *build_level_table(const Lot lot) {
+  LevelTable *table = calloc(1, sizeof(LevelTable));
+  if (!table) {
+    printf("ERROR: Memory allocation failed!\n");
+    exit(1);
+  }
+  int min_level, max_level;
+  if (level_range(lot, &min_level, &max_level)) {
+    long long span = (long long)max_level - min_level + 1; // far apart levels overflow an int
+    table->levels = span < INT_MAX ? calloc(span, sizeof(LevelSummary)) : NULL;
+    if (!table->levels) {
+      printf("ERROR: Memory allocation failed!\n");
+      exit(1);
+    }
+    table->min_level = min_level;
+    table->level_span = (int)span;
+  }
+  for (int i = 0; i < lot.space_count; i++) {
+    LevelSummary *entry = &table->levels[lot.spaces[i].location.level - table->min_level];
+    if (entry->space_count++ == 0) entry->first_space = i;
+    entry->end_space = i + 1;
+  }
+  for (int i = 0; i < lot.path_count; i++) {
+    LevelSummary *entry = &table->levels[lot.paths[i].start_point.level - table->min_level];
+    if (entry->path_count++ == 0) entry->first_path = i;
+    entry->end_path = i + 1;
+  }
+  for (int i = 0; i < lot.up_count; i++) {
+    table->levels[lot.ups[i].level - table->min_level].up_count++;
+  }
+  for (int i = 0; i < lot.down_count; i++) {
+    table->levels[lot.downs[i].level - table->min_level].down_count++;
+  }
+
+  for (int l = 0; l < table->level_span; l++) {
+    const LevelSummary *entry = &table->levels[l];
+    if (entry->space_count + entry->path_count + entry->up_count + entry->down_count > 0) table->level_count++;
+  }
+
+  // now that the counts are known, the buckets are one counting sort away
+  table->space_start = malloc(sizeof(int) * (table->level_span + 1));
+  table->path_start = malloc(sizeof(int) * (table->level_span + 1));
+  table->space_start[0] = table->path_start[0] = 0;
+  for (int l = 0; l < table->level_span; l++) {
+    table->space_start[l + 1] = table->space_start[l] + table->levels[l].space_count;
+    table->path_start[l + 1] = table->path_start[l] + table->levels[l].path_count;
+  }
+  table->space_order = malloc(sizeof(int) * (lot.space_count + 1));
+  table->path_order = malloc(sizeof(int) * (lot.path_count + 1));
+  int *fill = malloc(sizeof(int) * (table->level_span + 1));
+  for (int l = 0; l < table->level_span; l++) fill[l] = table->space_start[l];
+  for (int i = 0; i < lot.space_count; i++) {
+    table->space_order[fill[lot.spaces[i].location.level - table->min_level]++] = i;
+  }
+  for (int l = 0; l < table->level_span; l++) fill[l] = table->path_start[l];
+  for (int i = 0; i < lot.path_count; i++) {
+    table->path_order[fill[lot.paths[i].start_point.level - table->min_level]++] = i;
+  }
+  free(fill);
+  return table;
+}
+
+void free_level_table(LevelTable *table) {
+  if (!table) return;
+  free(table->levels);
+  free(table->space_order);
+  free(table->space_start);
+  free(table->path_order);
+  free(table->path_start);
+  free(table);
+}
+
+// what is on a level, or NULL if the lot has no level table or the level is outside it
+const LevelSummary *lot_level_summary(const Lot lot, int level) {
+  if (!lot.levels) return NULL;
+  int l = level - lot.levels->min_level;
+  if (l < 0 || l >= lot.levels->level_span) return NULL;
+  return &lot.levels->levels[l];
+}
+
+// the spaces on a level, in lot order; the list belongs to the table
+const int *level_spaces(const LevelTable *table, int level, int *out_count) {
+  int l = level - table->min_level;
+  if (l < 0 || l >= table->level_span) {
+    *out_count = 0;
+    return table->space_order;
+  }
+  *out_count = table->space_start[l + 1] - table->space_start[l];
+  return table->space_order + table->space_start[l];
+}
+
+// the paths on a level, in lot order; the list belongs to the table
+const int *level_paths(const LevelTable *table, int level, int *out_count) {
+  int l = level - table->min_level;
+  if (l < 0 || l >= table->level_span) {
+    *out_count = 0;
+    return table->path_order;
+  }
+  *out_count = table->path_start[l + 1] - table->path_start[l];
+  return table->path_order + table->path_start[l];
+}
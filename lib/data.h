@@ -1,4 +1,6 @@
 #pragma once
+#include <stddef.h>
+#include <stdint.h>
 
 typedef enum { Standard, Handicap, Compact, EV } SpaceType;
 
@@ -45,6 +47,14 @@ typedef struct {
   Location start_point;
 } Path;
 
+// everything about a space's footprint, which only depends on its type, location and rotation
+typedef struct {
+  Rectangle rect; // world space corners, see get_space_rectangle
+  Vector min;     // axis aligned bounding box of rect
+  Vector max;
+  Vector entry;   // middle of the entry side, between corner 0 and corner 1
+} SpaceGeometry;
+
 typedef struct {
   char plate[8];
   SpaceType type;
@@ -53,6 +63,59 @@ typedef struct {
 static const double path_clearance = 1.5;
 static const double path_accessibility = 4.0;
 
+// reverse index from a car to the space it is parked in
+typedef struct {
+  int *space_of; // space index per car index, -1 if the car is not parked
+  int capacity;  // number of car indices space_of has room for
+} CarSpaceMap;
+
+// the fields of every space that get scanned, stored column by column (structure of arrays)
+// column i belongs to lot.spaces[i]; scans over one field then read a tight array the compiler
+// can vectorise instead of dragging whole Space records through the cache
+typedef struct {
+  int *type;     // SpaceType of each space
+  int *level;
+  double *x;
+  double *y;
+  int *occupied; // car index or -1, kept in sync by occupy_space and vacate_space
+  int count;
+} SpaceColumns;
+
+// how much of each kind is on one level, and which stretch of the lot's arrays it sits in
+// every space on the level has an index in [first_space, end_space), and likewise for paths;
+// an empty stretch is [0, 0)
+typedef struct {
+  int space_count;
+  int path_count;
+  int up_count;
+  int down_count;
+  int first_space;
+  int end_space;
+  int first_path;
+  int end_path;
+} LevelSummary;
+
+// every level from min_level to min_level + level_span - 1, with its spaces and paths in buckets
+// the spaces on level min_level + l are space_order[space_start[l]] up to (but not including)
+// space_order[space_start[l + 1]], in lot order; paths work the same way
+typedef struct {
+  int min_level;
+  int level_span;
+  int level_count;      // levels with anything on them, which is what count_levels returns
+  LevelSummary *levels; // levels[l] is level min_level + l
+  int *space_order;
+  int *space_start;
+  int *path_order;
+  int *path_start;
+} LevelTable;
+
+// precomputed routing from the entrance, see nav.h
+typedef struct LotRouteIndex LotRouteIndex;
+// path corridors at one margin with a tree per level, see validate.h
+typedef struct CorridorIndex CorridorIndex;
+// free spaces ordered by distance from the entrance, see lot.h
+typedef struct SpaceQueues SpaceQueues;
+
 typedef struct {
   int level_count;
   Path *paths;
@@ -66,9 +129,31 @@ typedef struct {
   Location entrance;
   Location POI;
   double ramp_length;
+  LotRouteIndex *routes; // NULL until build_route_index is run for this lot
+  SpaceQueues *free_spaces; // NULL until build_space_queues is run for this lot
+  CarSpaceMap *parked; // NULL until build_car_space_map is run for this lot
+  SpaceColumns *columns; // NULL until build_space_columns is run for this lot
+  LevelTable *levels; // NULL until build_level_table is run for this lot
+  SpaceGeometry *geometry; // one per space, NULL until build_space_geometry is run for this lot
+  CorridorIndex *clearance_corridors; // at path_clearance, NULL until build_corridor_index is run for this lot
+  CorridorIndex *access_corridors;    // at path_accessibility, likewise
+  char *names; // arena holding every space name back to back, NULL if the names are owned elsewhere
+  void *mapping; // compiled lot file the arrays live in (see lotBinary.h), NULL if they are malloc'd
+  size_t mapping_size;
 } Lot;
 
 Location get_endpoint(const Path path);
 Rectangle get_space_rectangle(const Space space);
+SpaceGeometry get_space_geometry(const Space space);
+SpaceGeometry *build_space_geometry(const Lot lot);
+SpaceGeometry lot_space_geometry(const Lot lot, int space_index);
+Rectangle lot_space_rectangle(const Lot lot, int space_index);
+int level_span_out_of_range(const Lot lot, int *out_min_level, int *out_max_level);
+LevelTable *build_level_table(const Lot lot);
+void free_level_table(LevelTable *table);
+const LevelSummary *lot_level_summary(const Lot lot, int level);
+const int *level_spaces(const LevelTable *table, int level, int *out_count);
+const int *level_paths(const LevelTable *table, int level, int *out_count);
 int compare_locations(Location loc1, Location loc2);
+uint64_t hash_name(const char *name);
 int get_occupied_space_from_car(Lot lot, int CarIndex);
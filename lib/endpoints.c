@@ -0,0 +1,189 @@
+#include "endpoints.h"
+#include "data.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+// locations closer than this are treated as the same location
+static const double location_quantum = 1e-6;
+
+typedef struct {
+  long long x;
+  long long y;
+  int level;
+} LocationKey;
+
+static LocationKey quantise_location(Location loc) {
+  return (LocationKey){ llround(loc.x / location_quantum), llround(loc.y / location_quantum), loc.level };
+}
+
+static int keys_equal(LocationKey a, LocationKey b) {
+  return a.x == b.x && a.y == b.y && a.level == b.level;
+}
+
+// mixes the key into a well spread 64 bit hash (the splitmix64 finaliser)
+static uint64_t hash_key(LocationKey key) {
+  uint64_t h = (uint64_t)key.x * 0x9E3779B97F4A7C15ULL;
+  h ^= (uint64_t)key.y + 0x632BE59BD9B4E019ULL + (h << 6) + (h >> 2);
+  h ^= (uint64_t)(uint32_t)key.level * 0xC2B2AE3D27D4EB4FULL;
+  h ^= h >> 30;
+  h *= 0xBF58476D1CE4E5B9ULL;
+  h ^= h >> 27;
+  h *= 0x94D049BB133111EBULL;
+  h ^= h >> 31;
+  return h;
+}
+
+// returns the slot holding the key, or the empty slot where it belongs
+static int find_slot(const EndpointIndex *index, LocationKey key) {
+  int mask = index->slot_count - 1;
+  int slot = (int)(hash_key(key) & (uint64_t)mask);
+  while (index->slots[slot] != -1) {
+    Location stored = index->endpoints[index->slots[slot]].location;
+    if (keys_equal(quantise_location(stored), key)) break;
+    slot = (slot + 1) & mask; // linear probing
+  }
+  return slot;
+}
+
+// returns the endpoint of a location, creating it if it does not exist yet
+static int insert_location(EndpointIndex *index, Location loc) {
+  int slot = find_slot(index, quantise_location(loc));
+  if (index->slots[slot] == -1) {
+    index->endpoints[index->endpoint_count] = (Endpoint){ .location = loc };
+    index->slots[slot] = index->endpoint_count++;
+  }
+  return index->slots[slot];
+}
+
+// build the endpoint index of a lot
+// every path start, path end, up, down and the entrance gets an endpoint
+EndpointIndex build_endpoint_index(const Lot lot) {
+  EndpointIndex index = {0};
+
+  // the table is kept at most half full so probe sequences stay short
+  int capacity = 1 + 2 * lot.path_count + lot.up_count + lot.down_count;
+  index.slot_count = 1;
+  while (index.slot_count < 2 * capacity) index.slot_count <<= 1;
+  index.slots = malloc(sizeof(int) * index.slot_count);
+  for (int i = 0; i < index.slot_count; i++) index.slots[i] = -1;
+  index.endpoints = malloc(sizeof(Endpoint) * capacity);
+
+  // step 1: insert every location and count the paths meeting at each one
+  int *path_start = malloc(sizeof(int) * (lot.path_count + 1));
+  int *path_end = malloc(sizeof(int) * (lot.path_count + 1));
+  insert_location(&index, lot.entrance);
+  for (int i = 0; i < lot.path_count; i++) {
+    path_start[i] = insert_location(&index, lot.paths[i].start_point);
+    path_end[i] = insert_location(&index, get_endpoint(lot.paths[i]));
+    index.endpoints[path_start[i]].outgoing_count++;
+    index.endpoints[path_end[i]].incoming_count++;
+  }
+  for (int i = 0; i < lot.up_count; i++) {
+    index.endpoints[insert_location(&index, lot.ups[i])].is_up = 1;
+  }
+  for (int i = 0; i < lot.down_count; i++) {
+    index.endpoints[insert_location(&index, lot.downs[i])].is_down = 1;
+  }
+
+  // step 2: hand every endpoint its slice of path_refs, then fill the slices
+  index.path_refs = malloc(sizeof(int) * (2 * lot.path_count + 1));
+  int offset = 0;
+  for (int e = 0; e < index.endpoint_count; e++) {
+    index.endpoints[e].incoming = index.path_refs + offset;
+    offset += index.endpoints[e].incoming_count;
+    index.endpoints[e].outgoing = index.path_refs + offset;
+    offset += index.endpoints[e].outgoing_count;
+    index.endpoints[e].incoming_count = 0;
+    index.endpoints[e].outgoing_count = 0;
+  }
+  for (int i = 0; i < lot.path_count; i++) {
+    Endpoint *start = &index.endpoints[path_start[i]];
+    Endpoint *end = &index.endpoints[path_end[i]];
+    start->outgoing[start->outgoing_count++] = i;
+    end->incoming[end->incoming_count++] = i;
+  }
+  free(path_start);
+  free(path_end);
+
+  // step 3: remember the first up and down on every level
+  if (lot.up_count + lot.down_count > 0) {
+    int min_level = lot.up_count > 0 ? lot.ups[0].level : lot.downs[0].level;
+    int max_level = min_level;
+    for (int i = 0; i < lot.up_count; i++) {
+      if (lot.ups[i].level < min_level) min_level = lot.ups[i].level;
+      if (lot.ups[i].level > max_level) max_level = lot.ups[i].level;
+    }
+    for (int i = 0; i < lot.down_count; i++) {
+      if (lot.downs[i].level < min_level) min_level = lot.downs[i].level;
+      if (lot.downs[i].level > max_level) max_level = lot.downs[i].level;
+    }
+    index.min_level = min_level;
+    index.level_span = max_level - min_level + 1;
+    index.up_on_level = malloc(sizeof(int) * index.level_span);
+    index.down_on_level = malloc(sizeof(int) * index.level_span);
+    for (int l = 0; l < index.level_span; l++) {
+      index.up_on_level[l] = -1;
+      index.down_on_level[l] = -1;
+    }
+    // walk backwards so the first one in the lot wins
+    for (int i = lot.up_count - 1; i >= 0; i--) index.up_on_level[lot.ups[i].level - min_level] = i;
+    for (int i = lot.down_count - 1; i >= 0; i--) index.down_on_level[lot.downs[i].level - min_level] = i;
+  }
+
+  return index;
+}
+
+void free_endpoint_index(EndpointIndex index) {
+  free(index.endpoints);
+  free(index.slots);
+  free(index.path_refs);
+  free(index.up_on_level);
+  free(index.down_on_level);
+}
+
+// find the endpoint at a location, or -1 if nothing meets there
+int endpoint_index_of(const EndpointIndex *index, Location loc) {
+  if (index->slot_count == 0) return -1;
+  return index->slots[find_slot(index, quantise_location(loc))];
+}
+
+// returns the indices of all paths that end at a given location; the list is owned by the index
+const int *paths_with_endpoint(const EndpointIndex *index, Location loc, int *out_count) {
+  int e = endpoint_index_of(index, loc);
+  *out_count = e == -1 ? 0 : index->endpoints[e].incoming_count;
+  return e == -1 ? NULL : index->endpoints[e].incoming;
+}
+
+// returns the indices of all paths that start at a given location; the list is owned by the index
+const int *paths_with_start_point(const EndpointIndex *index, Location loc, int *out_count) {
+  int e = endpoint_index_of(index, loc);
+  *out_count = e == -1 ? 0 : index->endpoints[e].outgoing_count;
+  return e == -1 ? NULL : index->endpoints[e].outgoing;
+}
+
+// Check if a location is an "up" location on its level
+int is_up_location(const EndpointIndex *index, Location loc) {
+  int e = endpoint_index_of(index, loc);
+  return e != -1 && index->endpoints[e].is_up;
+}
+
+// Check if a location is a "down" location on its level
+int is_down_location(const EndpointIndex *index, Location loc) {
+  int e = endpoint_index_of(index, loc);
+  return e != -1 && index->endpoints[e].is_down;
+}
+
+// Get the "up" location on a given level (NULL if none exists)
+const Location *get_up_on_level(const Lot lot, const EndpointIndex *index, int level) {
+  int l = level - index->min_level;
+  if (l < 0 || l >= index->level_span || index->up_on_level[l] == -1) return NULL;
+  return &lot.ups[index->up_on_level[l]];
+}
+
+// Get the "down" location on a given level (NULL if none exists)
+const Location *get_down_on_level(const Lot lot, const EndpointIndex *index, int level) {
+  int l = level - index->min_level;
+  if (l < 0 || l >= index->level_span || index->down_on_level[l] == -1) return NULL;
+  return &lot.downs[index->down_on_level[l]];
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <data.h>
+
+// everything that meets at one location of the lot
+typedef struct {
+  Location location;
+  int *incoming;      // indices of the paths that end here
+  int incoming_count;
+  int *outgoing;      // indices of the paths that start here
+  int outgoing_count;
+  int is_up;
+  int is_down;
+} Endpoint;
+
+// hash table from a location to its Endpoint, built once when the lot loads
+// locations are quantised before hashing so they can be looked up without a linear scan
+typedef struct {
+  Endpoint *endpoints;
+  int endpoint_count;
+  int *slots;         // open addressing table of endpoint indices, -1 if empty
+  int slot_count;     // always a power of two
+  int *path_refs;     // storage behind every incoming/outgoing list
+  int min_level;
+  int level_span;
+  int *up_on_level;   // index into lot.ups of the first up on each level, -1 if none
+  int *down_on_level; // index into lot.downs of the first down on each level, -1 if none
+} EndpointIndex;
+
+EndpointIndex build_endpoint_index(const Lot lot);
+void free_endpoint_index(EndpointIndex index);
+int endpoint_index_of(const EndpointIndex *index, Location loc);
+const int *paths_with_endpoint(const EndpointIndex *index, Location loc, int *out_count);
+const int *paths_with_start_point(const EndpointIndex *index, Location loc, int *out_count);
+int is_up_location(const EndpointIndex *index, Location loc);
+int is_down_location(const EndpointIndex *index, Location loc);
+const Location *get_up_on_level(const Lot lot, const EndpointIndex *index, int level);
+const Location *get_down_on_level(const Lot lot, const EndpointIndex *index, int level);
@@ -0,0 +1,178 @@
+#include "graph.h"
+#include "calculations.h"
+#include "data.h"
+#include <float.h>
+#include <stdlib.h>
+
+// find the node index of a location, or -1 if the location is not in the graph
+int graph_node_of(const PathGraph graph, Location loc) {
+  return endpoint_index_of(&graph.endpoints, loc);
+}
+
+// adds the ramp edges leaving a node to edges (if not NULL) and returns how many there are
+// an up on level L leads to the down on level L + 1, and a down on level L leads to the up on level L - 1
+static int ramp_edges(const Lot lot, const PathGraph *graph, int node, GraphEdge *edges) {
+  const Endpoint *endpoint = &graph->endpoints.endpoints[node];
+  const Location *targets[2] = {
+    endpoint->is_up ? get_down_on_level(lot, &graph->endpoints, endpoint->location.level + 1) : NULL,
+    endpoint->is_down ? get_up_on_level(lot, &graph->endpoints, endpoint->location.level - 1) : NULL
+  };
+  int count = 0;
+  for (int i = 0; i < 2; i++) {
+    if (!targets[i]) continue;
+    if (edges) {
+      edges[count] = (GraphEdge){
+        .from = node,
+        .to = graph_node_of(*graph, *targets[i]),
+        .path_index = -1,
+        .weight = lot.ramp_length
+      };
+    }
+    count++;
+  }
+  return count;
+}
+
+// builds the weighted graph of a lot
+// every path becomes an edge from its start point to its endpoint, weighted by its length.
+// ramps become edges between levels, weighted by the lot's ramp length.
+PathGraph build_path_graph(const Lot lot) {
+  PathGraph graph = {0};
+  graph.endpoints = build_endpoint_index(lot);
+  graph.node_count = graph.endpoints.endpoint_count;
+
+  // the endpoint index already groups the paths by start point, so edges are laid out node by node
+  graph.edge_start = malloc(sizeof(int) * (graph.node_count + 1));
+  int edge_count = 0;
+  for (int n = 0; n < graph.node_count; n++) {
+    graph.edge_start[n] = edge_count;
+    edge_count += graph.endpoints.endpoints[n].outgoing_count + ramp_edges(lot, &graph, n, NULL);
+  }
+  graph.edge_start[graph.node_count] = edge_count;
+
+  graph.edges = malloc(sizeof(GraphEdge) * (edge_count + 1));
+  for (int n = 0; n < graph.node_count; n++) {
+    const Endpoint *endpoint = &graph.endpoints.endpoints[n];
+    GraphEdge *edge = &graph.edges[graph.edge_start[n]];
+    for (int i = 0; i < endpoint->outgoing_count; i++) {
+      const Path path = lot.paths[endpoint->outgoing[i]];
+      *edge++ = (GraphEdge){
+        .from = n,
+        .to = graph_node_of(graph, get_endpoint(path)),
+        .path_index = endpoint->outgoing[i],
+        .weight = vector_length(path.vector)
+      };
+    }
+    ramp_edges(lot, &graph, n, edge);
+  }
+  graph.edge_count = edge_count;
+
+  return graph;
+}
+
+void free_path_graph(PathGraph graph) {
+  free_endpoint_index(graph.endpoints);
+  free(graph.edges);
+  free(graph.edge_start);
+}
+
+// === Binary min-heap used by Dijkstra ===
+
+typedef struct {
+  double dist;
+  int node;
+} HeapEntry;
+
+static void heap_push(HeapEntry *heap, int *size, HeapEntry entry) {
+  int i = (*size)++;
+  // sift up: move the parent down until the new entry fits
+  while (i > 0) {
+    int parent = (i - 1) / 2;
+    if (heap[parent].dist <= entry.dist) break;
+    heap[i] = heap[parent];
+    i = parent;
+  }
+  heap[i] = entry;
+}
+
+static HeapEntry heap_pop(HeapEntry *heap, int *size) {
+  HeapEntry top = heap[0];
+  HeapEntry last = heap[--(*size)];
+  int i = 0;
+  // sift down: move the smaller child up until the last entry fits
+  while (1) {
+    int child = 2 * i + 1;
+    if (child >= *size) break;
+    if (child + 1 < *size && heap[child + 1].dist < heap[child].dist) child++;
+    if (last.dist <= heap[child].dist) break;
+    heap[i] = heap[child];
+    i = child;
+  }
+  if (*size > 0) heap[i] = last;
+  return top;
+}
+
+// Dijkstra's algorithm from the source node to every other node
+// dist[n] receives the shortest distance to node n (DBL_MAX if unreachable)
+// pred_edge[n] receives the index of the last edge on that route (-1 for the source and unreachable nodes)
+void shortest_paths_from(const PathGraph graph, int source, double *dist, int *pred_edge) {
+  for (int n = 0; n < graph.node_count; n++) {
+    dist[n] = DBL_MAX;
+    pred_edge[n] = -1;
+  }
+  if (source < 0 || source >= graph.node_count) return;
+
+  // every edge pushes at most one entry, plus one for the source
+  HeapEntry *heap = malloc(sizeof(HeapEntry) * (graph.edge_count + 1));
+  int size = 0;
+  dist[source] = 0.0;
+  heap_push(heap, &size, (HeapEntry){ 0.0, source });
+
+  while (size > 0) {
+    HeapEntry current = heap_pop(heap, &size);
+    if (current.dist > dist[current.node]) continue; // stale entry, a shorter route was already found
+
+    for (int e = graph.edge_start[current.node]; e < graph.edge_start[current.node + 1]; e++) {
+      double candidate = current.dist + graph.edges[e].weight;
+      int to = graph.edges[e].to;
+      if (candidate < dist[to]) {
+        dist[to] = candidate;
+        pred_edge[to] = e;
+        heap_push(heap, &size, (HeapEntry){ candidate, to });
+      }
+    }
+  }
+  free(heap);
+}
+
+// rebuild the route to the target node by walking the predecessor edges back to the source
+// only real paths are returned; ramps are skipped like the rest of nav expects
+// check dist before calling this, since an unreachable node looks just like the source here
+Path *graph_route_to(const Lot lot, const PathGraph graph, const int *pred_edge, int target, int *out_count) {
+  if (target < 0 || target >= graph.node_count) {
+    *out_count = -1;
+    return NULL;
+  }
+
+  // first count the paths on the route so we can allocate exactly once
+  int count = 0;
+  for (int n = target; pred_edge[n] != -1; n = graph.edges[pred_edge[n]].from) {
+    if (graph.edges[pred_edge[n]].path_index != -1) count++;
+  }
+
+  *out_count = count;
+  if (count == 0) {
+    return NULL;
+  }
+
+  // then fill the route in backwards since we are walking from the target
+  Path *route = malloc(sizeof(Path) * count);
+  int i = count;
+  for (int n = target; pred_edge[n] != -1; n = graph.edges[pred_edge[n]].from) {
+    int path_index = graph.edges[pred_edge[n]].path_index;
+    if (path_index != -1) {
+      route[--i] = lot.paths[path_index];
+    }
+  }
+  return route;
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <data.h>
+#include <endpoints.h>
+
+// a directed edge in the path graph; either a path or a ramp between levels
+typedef struct {
+  int from;
+  int to;
+  int path_index; // index into lot.paths, or -1 for a ramp
+  double weight;
+} GraphEdge;
+
+// weighted graph over every distinct location a car can drive between
+// node n is endpoint n of the endpoint index.
+// edges are stored grouped by their "from" node, so the outgoing edges of node n
+// are edges[edge_start[n]] up to (but not including) edges[edge_start[n + 1]]
+typedef struct {
+  EndpointIndex endpoints;
+  int node_count;
+  GraphEdge *edges;
+  int edge_count;
+  int *edge_start;
+} PathGraph;
+
+PathGraph build_path_graph(const Lot lot);
+void free_path_graph(PathGraph graph);
+int graph_node_of(const PathGraph graph, Location loc);
+void shortest_paths_from(const PathGraph graph, int source, double *dist, int *pred_edge);
+Path *graph_route_to(const Lot lot, const PathGraph graph, const int *pred_edge, int target, int *out_count);
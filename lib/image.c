@@ -1,10 +1,20 @@
 #include "image.h"
 #include "data.h"
 #include "calculations.h"
+#include "lot.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <pthread.h>
+
+// the buffer being drawn into and the part of it a drawing call may touch (max exclusive)
+// a tile only touches its own pixels, so tiles can be rasterised side by side into one buffer
+typedef struct {
+  Color *buffer;
+  int width, height;
+  int min_x, min_y, max_x, max_y;
+} Canvas;
 
 // ============================================================================
 // Color Helpers
@@ -22,9 +32,9 @@ static Color get_space_color(SpaceType type) {
 }
 
 // Helper function to read the color of a pixel based on coordinates
-static Color get_pixel(Color *buffer, int img_width, int img_height, int x, int y) {
-  if (x >= 0 && x < img_width && y >= 0 && y < img_height) {
-    return buffer[y * img_width + x];
+static Color get_pixel(const Canvas *canvas, int x, int y) {
+  if (x >= canvas->min_x && x < canvas->max_x && y >= canvas->min_y && y < canvas->max_y) {
+    return canvas->buffer[y * canvas->width + x];
   }
   return COLOR_BACKGROUND;
 }
@@ -47,22 +57,26 @@ static Color blend_colors(Color bg, Color fg, double alpha) {
 }
 
 // Helper function to set the color of a pixel based on coordinates
-static void set_pixel(Color *buffer, int img_width, int img_height, int x, int y, Color color) {
-  if (x >= 0 && x < img_width && y >= 0 && y < img_height) {
-    buffer[y * img_width + x] = color;
+static void set_pixel(const Canvas *canvas, int x, int y, Color color) {
+  if (x >= canvas->min_x && x < canvas->max_x && y >= canvas->min_y && y < canvas->max_y) {
+    canvas->buffer[y * canvas->width + x] = color;
   }
 }
 
 // Helper function that combines get_pixel, blend_colors, and set_pixel
 // blends a color with the background and sets the pixel
-static void set_pixel_alpha(Color *buffer, int img_width, int img_height,
-                            int x, int y, Color color, double alpha) {
-  if (x >= 0 && x < img_width && y >= 0 && y < img_height) {
-    Color bg = get_pixel(buffer, img_width, img_height, x, y);
-    set_pixel(buffer, img_width, img_height, x, y, blend_colors(bg, color, alpha));
+static void set_pixel_alpha(const Canvas *canvas, int x, int y, Color color, double alpha) {
+  if (x >= canvas->min_x && x < canvas->max_x && y >= canvas->min_y && y < canvas->max_y) {
+    Color bg = get_pixel(canvas, x, y);
+    set_pixel(canvas, x, y, blend_colors(bg, color, alpha));
   }
 }
 
+// the canvas of a whole image, for drawing without tiles
+static Canvas image_canvas(Color *buffer, int img_width, int img_height) {
+  return (Canvas){ buffer, img_width, img_height, 0, 0, img_width, img_height };
+}
+
 // ============================================================================
 // Vector Math Helpers
 // ============================================================================
@@ -102,9 +116,7 @@ static double rfpart(double x) {
 // Wu's line algorithm with thickness support
 // Please read https://en.wikipedia.org/wiki/Xiaolin_Wu%27s_line_algorithm to understand this
 // Or at least to see that this is a C implementation of the pseudocode under the section "Floating Point Implementation"
-void draw_line(Color *buffer, int img_width, int img_height,
-               double x0, double y0, double x1, double y1,
-               Color color, int thickness) {
+static void canvas_line(const Canvas *canvas, double x0, double y0, double x1, double y1, Color color, int thickness) {
   // thickness support outside the scope of Wu's algorithm
   // simply calls itself multiple times offset by perpendicular vectors
   if (thickness > 1) {
@@ -116,14 +128,20 @@ void draw_line(Color *buffer, int img_width, int img_height,
 
     for (int t = -thickness / 2; t <= thickness / 2; t++) {
       Vector offset = vector_scale(perp, (double)t);
-      draw_line(buffer, img_width, img_height,
-                x0 + offset.x, y0 + offset.y,
-                x1 + offset.x, y1 + offset.y,
-                color, 1);
+      canvas_line(canvas,
+                  x0 + offset.x, y0 + offset.y,
+                  x1 + offset.x, y1 + offset.y,
+                  color, 1);
     }
     return;
   }
 
+  // every pixel Wu's algorithm touches is within 2 of the line, so a line that far from the canvas can be skipped
+  if (fmax(x0, x1) < canvas->min_x - 2 || fmin(x0, x1) >= canvas->max_x + 2 ||
+      fmax(y0, y1) < canvas->min_y - 2 || fmin(y0, y1) >= canvas->max_y + 2) {
+    return;
+  }
+
   // In the wise words of Xiaolin Wu:
   int steep = fabs(y1 - y0) > fabs(x1 - x0); // y difference greater than x difference, the line forms an acute angle with the y-axis
                                              // this is relevant because the algorithm only takes into account the single pixels above and below the line
@@ -187,12 +205,12 @@ void draw_line(Color *buffer, int img_width, int img_height,
   // complement (fpart). This is seen in the final argument to set_pixel_alpha below.
   if (steep) {
     // if steep, we swapped x and y earlier, so we need to swap them back here
-    set_pixel_alpha(buffer, img_width, img_height, ypxl1, xpxl1, color, rfpart(yend) * xgap);
-    set_pixel_alpha(buffer, img_width, img_height, ypxl1 + 1, xpxl1, color, fpart(yend) * xgap);
+    set_pixel_alpha(canvas, ypxl1, xpxl1, color, rfpart(yend) * xgap);
+    set_pixel_alpha(canvas, ypxl1 + 1, xpxl1, color, fpart(yend) * xgap);
   } else {
     // otherwise just set the pixel normally
-    set_pixel_alpha(buffer, img_width, img_height, xpxl1, ypxl1, color, rfpart(yend) * xgap);
-    set_pixel_alpha(buffer, img_width, img_height, xpxl1, ypxl1 + 1, color, fpart(yend) * xgap);
+    set_pixel_alpha(canvas, xpxl1, ypxl1, color, rfpart(yend) * xgap);
+    set_pixel_alpha(canvas, xpxl1, ypxl1 + 1, color, fpart(yend) * xgap);
   }
 
   // intery is the y-value at the next integer x step: yend + slope
@@ -207,11 +225,11 @@ void draw_line(Color *buffer, int img_width, int img_height,
   int ypxl2 = (int)floor(yend);
 
   if (steep) {
-    set_pixel_alpha(buffer, img_width, img_height, ypxl2, xpxl2, color, rfpart(yend) * xgap);
-    set_pixel_alpha(buffer, img_width, img_height, ypxl2 + 1, xpxl2, color, fpart(yend) * xgap);
+    set_pixel_alpha(canvas, ypxl2, xpxl2, color, rfpart(yend) * xgap);
+    set_pixel_alpha(canvas, ypxl2 + 1, xpxl2, color, fpart(yend) * xgap);
   } else {
-    set_pixel_alpha(buffer, img_width, img_height, xpxl2, ypxl2, color, rfpart(yend) * xgap);
-    set_pixel_alpha(buffer, img_width, img_height, xpxl2, ypxl2 + 1, color, fpart(yend) * xgap);
+    set_pixel_alpha(canvas, xpxl2, ypxl2, color, rfpart(yend) * xgap);
+    set_pixel_alpha(canvas, xpxl2, ypxl2 + 1, color, fpart(yend) * xgap);
   }
 
   // Main loop where we iterate over the x values between the two endpoints
@@ -222,23 +240,32 @@ void draw_line(Color *buffer, int img_width, int img_height,
   //  - fpart(intery) gives the intensity weight for the pixel above it.
   // At each step, we increment intery by the slope (gradient).
   // Again, the only difference between steep and not steep is whether we swap x and y when setting pixels.
+  // intery has to be stepped from the start to land on exactly the same values,
+  // but once x is past the end of the canvas nothing more can be drawn
   if (steep) {
-    for (int x = xpxl1 + 1; x < xpxl2; x++) {
+    for (int x = xpxl1 + 1; x < xpxl2 && x < canvas->max_y; x++) {
       int y = (int)floor(intery);
-      set_pixel_alpha(buffer, img_width, img_height, y, x, color, rfpart(intery));
-      set_pixel_alpha(buffer, img_width, img_height, y + 1, x, color, fpart(intery));
+      set_pixel_alpha(canvas, y, x, color, rfpart(intery));
+      set_pixel_alpha(canvas, y + 1, x, color, fpart(intery));
       intery += gradient;
     }
   } else {
-    for (int x = xpxl1 + 1; x < xpxl2; x++) {
+    for (int x = xpxl1 + 1; x < xpxl2 && x < canvas->max_x; x++) {
       int y = (int)floor(intery);
-      set_pixel_alpha(buffer, img_width, img_height, x, y, color, rfpart(intery));
-      set_pixel_alpha(buffer, img_width, img_height, x, y + 1, color, fpart(intery));
+      set_pixel_alpha(canvas, x, y, color, rfpart(intery));
+      set_pixel_alpha(canvas, x, y + 1, color, fpart(intery));
       intery += gradient;
     }
   }
 }
 
+void draw_line(Color *buffer, int img_width, int img_height,
+               double x0, double y0, double x1, double y1,
+               Color color, int thickness) {
+  Canvas canvas = image_canvas(buffer, img_width, img_height);
+  canvas_line(&canvas, x0, y0, x1, y1, color, thickness);
+}
+
 // Function to draw a filled circle with optional outline.
 // The algorithm works by iterating over a bounding box around the circle and
 // estimating pixel coverage by sampling multiple sub-pixel locations.
@@ -246,9 +273,7 @@ void draw_line(Color *buffer, int img_width, int img_height,
 // - For each sub-sample, we test whether it lies inside the circle, inside the outline band, or outside entirely.
 // - Coverage is accumulated as alpha and blended against the buffer.
 // Very brute-force technique.
-void draw_circle(Color *buffer, int img_width, int img_height, double cx, double cy, double radius, const Color *fill_color, const Color *outline_color, int outline_thickness) {
-  if (!buffer) return;
-
+static void canvas_circle(const Canvas *canvas, double cx, double cy, double radius, const Color *fill_color, const Color *outline_color, int outline_thickness) {
   // First we find the bounding box of the circle plus outline
   int padding = outline_thickness + 2;
   int start_x = (int)floor(cx - radius) - padding;
@@ -256,11 +281,11 @@ void draw_circle(Color *buffer, int img_width, int img_height, double cx, double
   int start_y = (int)floor(cy - radius) - padding;
   int end_y   = (int)ceil(cy + radius) + padding;
 
-  // Clamp to image bounds
-  if (start_x < 0) start_x = 0;
-  if (start_y < 0) start_y = 0;
-  if (end_x >= img_width) end_x = img_width - 1;
-  if (end_y >= img_height) end_y = img_height - 1;
+  // Clamp to the canvas; every pixel's coverage only depends on where it is, so this changes nothing else
+  if (start_x < canvas->min_x) start_x = canvas->min_x;
+  if (start_y < canvas->min_y) start_y = canvas->min_y;
+  if (end_x >= canvas->max_x) end_x = canvas->max_x - 1;
+  if (end_y >= canvas->max_y) end_y = canvas->max_y - 1;
 
   Vector center = { cx, cy };
 
@@ -320,7 +345,7 @@ void draw_circle(Color *buffer, int img_width, int img_height, double cx, double
       // final pixel composition; first, did we cover anything at all?
       if (outline_coverage > 0.0 || fill_coverage > 0.0) {
         // we did! so, get the background color and assign it a result which we will modify
-        Color bg = get_pixel(buffer, img_width, img_height, px, py);
+        Color bg = get_pixel(canvas, px, py);
         Color result = bg;
 
         // if there's some fill coverage, blend it in proportionally to the coverage
@@ -334,17 +359,21 @@ void draw_circle(Color *buffer, int img_width, int img_height, double cx, double
         }
 
         // finally, set the pixel to the computed result
-        set_pixel(buffer, img_width, img_height, px, py, result);
+        set_pixel(canvas, px, py, result);
       }
     }
   }
 }
 
-// Function to draw a filled rectangle with optional outline.
-// works similarly to draw_circle with supersampling for anti-aliasing
-void draw_rectangle(Color *buffer, int img_width, int img_height, const Rectangle rect, const Color *fill_color, const Color *outline_color, int outline_thickness) {
+void draw_circle(Color *buffer, int img_width, int img_height, double cx, double cy, double radius, const Color *fill_color, const Color *outline_color, int outline_thickness) {
   if (!buffer) return;
+  Canvas canvas = image_canvas(buffer, img_width, img_height);
+  canvas_circle(&canvas, cx, cy, radius, fill_color, outline_color, outline_thickness);
+}
 
+// Function to draw a filled rectangle with optional outline.
+// works similarly to draw_circle with supersampling for anti-aliasing
+static void canvas_rectangle(const Canvas *canvas, const Rectangle rect, const Color *fill_color, const Color *outline_color, int outline_thickness) {
   // Find bounding box
   double min_x = rect.corner[0].x, max_x = rect.corner[0].x;
   double min_y = rect.corner[0].y, max_y = rect.corner[0].y;
@@ -363,11 +392,11 @@ void draw_rectangle(Color *buffer, int img_width, int img_height, const Rectangl
   int start_y = (int)floor(min_y) - padding;
   int end_y   = (int)ceil(max_y) + padding;
 
-  // Clamp to image bounds
-  if (start_x < 0) start_x = 0;
-  if (start_y < 0) start_y = 0;
-  if (end_x >= img_width) end_x = img_width - 1;
-  if (end_y >= img_height) end_y = img_height - 1;
+  // Clamp to the canvas
+  if (start_x < canvas->min_x) start_x = canvas->min_x;
+  if (start_y < canvas->min_y) start_y = canvas->min_y;
+  if (end_x >= canvas->max_x) end_x = canvas->max_x - 1;
+  if (end_y >= canvas->max_y) end_y = canvas->max_y - 1;
 
   // Outline thickness is centered on the geometric edge
   double half_thickness = (double)outline_thickness / 2.0;
@@ -428,7 +457,7 @@ void draw_rectangle(Color *buffer, int img_width, int img_height, const Rectangl
 
       // final pixel composition; again, just like draw_circle.
       if (outline_coverage > 0.0 || fill_coverage > 0.0) {
-        Color bg = get_pixel(buffer, img_width, img_height, px, py);
+        Color bg = get_pixel(canvas, px, py);
         Color result = bg;
 
         if (fill_color && fill_coverage > 0.0) {
@@ -439,18 +468,24 @@ void draw_rectangle(Color *buffer, int img_width, int img_height, const Rectangl
         }
 
         // set the pixel to the computed result
-        set_pixel(buffer, img_width, img_height, px, py, result);
+        set_pixel(canvas, px, py, result);
       }
     }
   }
 }
 
+void draw_rectangle(Color *buffer, int img_width, int img_height, const Rectangle rect, const Color *fill_color, const Color *outline_color, int outline_thickness) {
+  if (!buffer) return;
+  Canvas canvas = image_canvas(buffer, img_width, img_height);
+  canvas_rectangle(&canvas, rect, fill_color, outline_color, outline_thickness);
+}
+
 // ============================================================================
 // Text Rendering
 // ============================================================================
 
 // Simple function to draw text using a basic bitmap font
-static void draw_text(Color *buffer, int img_width, int img_height, const char *text, int center_x, int center_y, Color color) {
+static void draw_text(const Canvas *canvas, const char *text, int center_x, int center_y, Color color) {
   const int char_width = 5;
   const int char_height = 7;
   const int spacing = 1;
@@ -536,7 +571,7 @@ static void draw_text(Color *buffer, int img_width, int img_height, const char *
           // you can see vertically that the 4th bit is 1 in both rows,
           // the bitwise AND will yield non-zero, passing the if check and drawing the pixel!
           if (font[font_index][row] & (1 << (char_width - 1 - col))) {
-            set_pixel(buffer, img_width, img_height, x + col, start_y + row, color);
+            set_pixel(canvas, x + col, start_y + row, color);
           }
         }
       }
@@ -545,8 +580,8 @@ static void draw_text(Color *buffer, int img_width, int img_height, const char *
 }
 
 // Function to draw a space label at the center of a rectangle
-void draw_space_label(Color *buffer, int img_width, int img_height, const Rectangle pixel_rect, const char *name) {
-  if (!buffer || !name) return;
+static void canvas_space_label(const Canvas *canvas, const Rectangle pixel_rect, const char *name) {
+  if (!name) return;
 
   int max_chars = 10;
   int len = strlen(name);
@@ -562,17 +597,28 @@ void draw_space_label(Color *buffer, int img_width, int img_height, const Rectan
   center_x /= 4.0;
   center_y /= 4.0;
 
-  draw_text(buffer, img_width, img_height, name, (int)center_x, (int)center_y, COLOR_BLACK);
+  draw_text(canvas, name, (int)center_x, (int)center_y, COLOR_BLACK);
+}
+
+void draw_space_label(Color *buffer, int img_width, int img_height, const Rectangle pixel_rect, const char *name) {
+  if (!buffer) return;
+  Canvas canvas = image_canvas(buffer, img_width, img_height);
+  canvas_space_label(&canvas, pixel_rect, name);
 }
 
 // Function to draw the level label at the top-left corner
-void draw_level_label(Color *buffer, int img_width, int img_height, int level, int margin) {
+static void canvas_level_label(const Canvas *canvas, int level, int margin) {
   int x = margin;
   int y = margin;
   char level_text[10];
   sprintf(level_text, "level %d", level);
 
-  draw_text(buffer, img_width, img_height, level_text, x + (int)(2.5 * strlen(level_text)), y, COLOR_BLACK);
+  draw_text(canvas, level_text, x + (int)(2.5 * strlen(level_text)), y, COLOR_BLACK);
+}
+
+void draw_level_label(Color *buffer, int img_width, int img_height, int level, int margin) {
+  Canvas canvas = image_canvas(buffer, img_width, img_height);
+  canvas_level_label(&canvas, level, margin);
 }
 
 // ============================================================================
@@ -580,32 +626,32 @@ void draw_level_label(Color *buffer, int img_width, int img_height, int level, i
 // ============================================================================
 
 // draws the scale bar, representing 1 unit of distance, so the user can tell how big things are
-void draw_scale_bar(Color *buffer, int img_width, int img_height, int pixels_per_unit, int margin) {
+static void canvas_scale_bar(const Canvas *canvas, int pixels_per_unit, int margin) {
   int bar_length = pixels_per_unit;
   int bar_height = 4;
   int tick_height = 10;
 
   int x_start = margin;
-  int y_bar = img_height - margin - tick_height;
+  int y_bar = canvas->height - margin - tick_height;
 
   // Horizontal bar
   for (int y = y_bar; y < y_bar + bar_height; y++) {
     for (int x = x_start; x < x_start + bar_length; x++) {
-      set_pixel(buffer, img_width, img_height, x, y, COLOR_BLACK);
+      set_pixel(canvas, x, y, COLOR_BLACK);
     }
   }
 
   // Left tick
   for (int y = y_bar - (tick_height - bar_height); y < y_bar + bar_height; y++) {
     for (int x = x_start; x < x_start + 2; x++) {
-      set_pixel(buffer, img_width, img_height, x, y, COLOR_BLACK);
+      set_pixel(canvas, x, y, COLOR_BLACK);
     }
   }
 
   // Right tick
   for (int y = y_bar - (tick_height - bar_height); y < y_bar + bar_height; y++) {
     for (int x = x_start + bar_length - 2; x < x_start + bar_length; x++) {
-      set_pixel(buffer, img_width, img_height, x, y, COLOR_BLACK);
+      set_pixel(canvas, x, y, COLOR_BLACK);
     }
   }
 
@@ -616,17 +662,22 @@ void draw_scale_bar(Color *buffer, int img_width, int img_height, int pixels_per
   int one_width = 6;
 
   for (int y = one_y; y < one_y + one_height; y++) {
-    set_pixel(buffer, img_width, img_height, one_x, y, COLOR_BLACK);
-    set_pixel(buffer, img_width, img_height, one_x + 1, y, COLOR_BLACK);
+    set_pixel(canvas, one_x, y, COLOR_BLACK);
+    set_pixel(canvas, one_x + 1, y, COLOR_BLACK);
   }
 
   for (int x = one_x - 2; x < one_x + one_width - 2; x++) {
-    set_pixel(buffer, img_width, img_height, x, one_y + one_height - 1, COLOR_BLACK);
-    set_pixel(buffer, img_width, img_height, x, one_y + one_height - 2, COLOR_BLACK);
+    set_pixel(canvas, x, one_y + one_height - 1, COLOR_BLACK);
+    set_pixel(canvas, x, one_y + one_height - 2, COLOR_BLACK);
   }
 
-  set_pixel(buffer, img_width, img_height, one_x - 1, one_y + 1, COLOR_BLACK);
-  set_pixel(buffer, img_width, img_height, one_x - 2, one_y + 2, COLOR_BLACK);
+  set_pixel(canvas, one_x - 1, one_y + 1, COLOR_BLACK);
+  set_pixel(canvas, one_x - 2, one_y + 2, COLOR_BLACK);
+}
+
+void draw_scale_bar(Color *buffer, int img_width, int img_height, int pixels_per_unit, int margin) {
+  Canvas canvas = image_canvas(buffer, img_width, img_height);
+  canvas_scale_bar(&canvas, pixels_per_unit, margin);
 }
 
 // ============================================================================
@@ -634,34 +685,37 @@ void draw_scale_bar(Color *buffer, int img_width, int img_height, int pixels_per
 // ============================================================================
 
 // Function to calculate the bounding box of the lot at a given level
-static void calculate_lot_bounds(const Lot lot, int level, double *min_x, double *min_y, double *max_x, double *max_y) {
+// only the spaces and paths in the level's buckets are looked at
+static void calculate_lot_bounds(const Lot lot, const LevelTable *levels, int level, double *min_x, double *min_y, double *max_x, double *max_y) {
   *min_x = *min_y = 1e9;
   *max_x = *max_y = -1e9;
 
-  for (int i = 0; i < lot.space_count; i++) {
-    if (lot.spaces[i].location.level == level) {
-      Rectangle rect = get_space_rectangle(lot.spaces[i]);
-      for (int j = 0; j < 4; j++) {
-        if (rect.corner[j].x < *min_x) *min_x = rect.corner[j].x;
-        if (rect.corner[j].x > *max_x) *max_x = rect.corner[j].x;
-        if (rect.corner[j].y < *min_y) *min_y = rect.corner[j].y;
-        if (rect.corner[j].y > *max_y) *max_y = rect.corner[j].y;
-      }
+  int space_count, path_count;
+  const int *spaces = level_spaces(levels, level, &space_count);
+  const int *paths = level_paths(levels, level, &path_count);
+
+  for (int k = 0; k < space_count; k++) {
+    int i = spaces[k];
+    Rectangle rect = lot_space_rectangle(lot, i);
+    for (int j = 0; j < 4; j++) {
+      if (rect.corner[j].x < *min_x) *min_x = rect.corner[j].x;
+      if (rect.corner[j].x > *max_x) *max_x = rect.corner[j].x;
+      if (rect.corner[j].y < *min_y) *min_y = rect.corner[j].y;
+      if (rect.corner[j].y > *max_y) *max_y = rect.corner[j].y;
     }
   }
 
-  for (int i = 0; i < lot.path_count; i++) {
-    if (lot.paths[i].start_point.level == level) {
-      Location end = get_endpoint(lot.paths[i]);
-      if (lot.paths[i].start_point.x < *min_x) *min_x = lot.paths[i].start_point.x;
-      if (lot.paths[i].start_point.x > *max_x) *max_x = lot.paths[i].start_point.x;
-      if (lot.paths[i].start_point.y < *min_y) *min_y = lot.paths[i].start_point.y;
-      if (lot.paths[i].start_point.y > *max_y) *max_y = lot.paths[i].start_point.y;
-      if (end.x < *min_x) *min_x = end.x;
-      if (end.x > *max_x) *max_x = end.x;
-      if (end.y < *min_y) *min_y = end.y;
-      if (end.y > *max_y) *max_y = end.y;
-    }
+  for (int k = 0; k < path_count; k++) {
+    int i = paths[k];
+    Location end = get_endpoint(lot.paths[i]);
+    if (lot.paths[i].start_point.x < *min_x) *min_x = lot.paths[i].start_point.x;
+    if (lot.paths[i].start_point.x > *max_x) *max_x = lot.paths[i].start_point.x;
+    if (lot.paths[i].start_point.y < *min_y) *min_y = lot.paths[i].start_point.y;
+    if (lot.paths[i].start_point.y > *max_y) *max_y = lot.paths[i].start_point.y;
+    if (end.x < *min_x) *min_x = end.x;
+    if (end.x > *max_x) *max_x = end.x;
+    if (end.y < *min_y) *min_y = end.y;
+    if (end.y > *max_y) *max_y = end.y;
   }
 
   if (lot.entrance.level == level) {
@@ -713,123 +767,308 @@ static Rectangle world_to_pixel_rect(const Rectangle world_rect, double pixels_p
   return pixel_rect;
 }
 
-// Main function to render a lot level to a PPM image file
-// Combines the various drawing functions defined above
-// using them to draw all components of the lot
-int lot_to_ppm(const Lot lot, const char *filename, int level, int pixels_per_unit, Path* nav, int nav_count) {
-  if (!filename || pixels_per_unit <= 0) return -1;
+// ============================================================================
+// Tiled Rendering
+// ============================================================================
 
-  double min_x, min_y, max_x, max_y;
-  calculate_lot_bounds(lot, level, &min_x, &min_y, &max_x, &max_y);
+// the image is split into square tiles of this many pixels
+static const int tile_size = 128;
+
+// a glyph of a label reaches this far from where the label is centered
+static const int label_reach_x = 32;
+static const int label_reach_y = 8;
+
+// everything drawn on a level except the border, scale bar and label, in the order it is drawn
+typedef enum { DrawPath, DrawNav, DrawSpace, DrawEntrance, DrawPOI, DrawUp, DrawDown } DrawKind;
+
+typedef struct {
+  DrawKind kind;
+  int index; // into the lot's paths, spaces, ups or downs, or into nav
+} DrawItem;
+
+// one level being rendered; the items are binned by tile, so every tile knows which of them can touch it
+typedef struct {
+  Lot lot;
+  int level;
+  int pixels_per_unit;
+  const Path *nav;
+  double min_x, max_y;
+  Canvas image;
+  const DrawItem *items;
+  int tile_width, tile_height;
+  int tile_columns, tile_rows;
+  int *tile_start; // the items of tile t are tile_items[tile_start[t]] up to tile_items[tile_start[t + 1]]
+  int *tile_items;
+} LevelRender;
+
+typedef struct {
+  const LevelRender *render;
+  int tile;
+} TileTask;
+
+static double to_pixel_x(const LevelRender *render, double x) {
+  return (x - render->min_x) * render->pixels_per_unit;
+}
 
-  int img_width = (int)((max_x - min_x) * pixels_per_unit);
-  int img_height = (int)((max_y - min_y) * pixels_per_unit);
+static double to_pixel_y(const LevelRender *render, double y) {
+  return (render->max_y - y) * render->pixels_per_unit;
+}
 
-  if (img_width <= 0 || img_height <= 0) return -1;
+static void marker_of(const LevelRender *render, DrawItem item, Location *location, double *radius, Color *color) {
+  const Lot *lot = &render->lot;
+  switch (item.kind) {
+    case DrawEntrance: *location = lot->entrance; *radius = render->pixels_per_unit * 0.8; *color = COLOR_ENTRANCE; break;
+    case DrawPOI: *location = lot->POI; *radius = render->pixels_per_unit * 0.6; *color = COLOR_POI; break;
+    case DrawUp: *location = lot->ups[item.index]; *radius = render->pixels_per_unit * 0.5; *color = COLOR_UP; break;
+    default: *location = lot->downs[item.index]; *radius = render->pixels_per_unit * 0.5; *color = COLOR_DOWN; break;
+  }
+}
 
-  Color *buffer = malloc(img_width * img_height * sizeof(Color));
-  if (!buffer) return -1;
+static void draw_item(const LevelRender *render, const Canvas *canvas, DrawItem item) {
+  const Lot *lot = &render->lot;
+  if (item.kind == DrawPath || item.kind == DrawNav) {
+    Path path = item.kind == DrawPath ? lot->paths[item.index] : render->nav[item.index];
+    Location end = get_endpoint(path);
+    canvas_line(canvas,
+                to_pixel_x(render, path.start_point.x), to_pixel_y(render, path.start_point.y),
+                to_pixel_x(render, end.x), to_pixel_y(render, end.y),
+                item.kind == DrawPath ? COLOR_PATH : COLOR_RED,
+                item.kind == DrawPath ? render->pixels_per_unit * 3 : render->pixels_per_unit / 3);
+  } else if (item.kind == DrawSpace) {
+    Rectangle world_rect = lot_space_rectangle(*lot, item.index);
+    Rectangle pixel_rect = world_to_pixel_rect(world_rect, render->pixels_per_unit, render->min_x, render->max_y);
+    Color fill = get_space_color(lot->spaces[item.index].type);
+    canvas_rectangle(canvas, pixel_rect, &fill, &COLOR_BLACK, 2);
+    canvas_space_label(canvas, pixel_rect, lot->spaces[item.index].name);
+  } else {
+    Location location;
+    double radius;
+    Color color;
+    marker_of(render, item, &location, &radius, &color);
+    canvas_circle(canvas, to_pixel_x(render, location.x), to_pixel_y(render, location.y), radius, &color, &COLOR_BLACK, 0);
+  }
+}
 
-  for (int i = 0; i < img_width * img_height; i++) {
-    buffer[i] = COLOR_BACKGROUND;
-  }
-
-  for (int i = 0; i < img_width; i++) {
-    set_pixel(buffer, img_width, img_height, i, 0, COLOR_BLACK);
-    set_pixel(buffer, img_width, img_height, i, img_height - 1, COLOR_BLACK);
-  }
-  for (int i = 0; i < img_height; i++) {
-    set_pixel(buffer, img_width, img_height, 0, i, COLOR_BLACK);
-    set_pixel(buffer, img_width, img_height, img_width - 1, i, COLOR_BLACK);
-  }
-
-  #define TO_PX_X(wx) (((wx) - min_x) * pixels_per_unit)
-  #define TO_PX_Y(wy) ((max_y - (wy)) * pixels_per_unit)
-
-  // Draw paths
-  for (int i = 0; i < lot.path_count; i++) {
-    if (lot.paths[i].start_point.level == level) {
-      Location end = get_endpoint(lot.paths[i]);
-      draw_line(
-        buffer,
-        img_width,
-        img_height,
-        TO_PX_X(lot.paths[i].start_point.x),
-        TO_PX_Y(lot.paths[i].start_point.y),
-        TO_PX_X(end.x),
-        TO_PX_Y(end.y),
-        COLOR_PATH,
-        pixels_per_unit * 3
-      );
+// the pixels an item can touch, with enough room for anti-aliasing and labels
+static void item_bounds(const LevelRender *render, DrawItem item, double *min_x, double *min_y, double *max_x, double *max_y) {
+  const Lot *lot = &render->lot;
+  double reach_x, reach_y;
+  if (item.kind == DrawPath || item.kind == DrawNav) {
+    Path path = item.kind == DrawPath ? lot->paths[item.index] : render->nav[item.index];
+    Location end = get_endpoint(path);
+    int thickness = item.kind == DrawPath ? render->pixels_per_unit * 3 : render->pixels_per_unit / 3;
+    *min_x = fmin(to_pixel_x(render, path.start_point.x), to_pixel_x(render, end.x));
+    *max_x = fmax(to_pixel_x(render, path.start_point.x), to_pixel_x(render, end.x));
+    *min_y = fmin(to_pixel_y(render, path.start_point.y), to_pixel_y(render, end.y));
+    *max_y = fmax(to_pixel_y(render, path.start_point.y), to_pixel_y(render, end.y));
+    reach_x = reach_y = thickness / 2 + 3;
+  } else if (item.kind == DrawSpace) {
+    Rectangle rect = world_to_pixel_rect(lot_space_rectangle(*lot, item.index), render->pixels_per_unit, render->min_x, render->max_y);
+    *min_x = *max_x = rect.corner[0].x;
+    *min_y = *max_y = rect.corner[0].y;
+    for (int i = 1; i < 4; i++) {
+      *min_x = fmin(*min_x, rect.corner[i].x);
+      *max_x = fmax(*max_x, rect.corner[i].x);
+      *min_y = fmin(*min_y, rect.corner[i].y);
+      *max_y = fmax(*max_y, rect.corner[i].y);
     }
+    // the label is centered inside the rectangle but can be wider than it
+    reach_x = label_reach_x;
+    reach_y = label_reach_y;
+  } else {
+    Location location;
+    double radius;
+    Color color;
+    marker_of(render, item, &location, &radius, &color);
+    *min_x = *max_x = to_pixel_x(render, location.x);
+    *min_y = *max_y = to_pixel_y(render, location.y);
+    reach_x = reach_y = radius + 3;
   }
+  *min_x -= reach_x;
+  *max_x += reach_x;
+  *min_y -= reach_y;
+  *max_y += reach_y;
+}
 
-  // if nav data is provided, draw it
-  for (int i = 0; i < nav_count; i++) {
-    if (nav[i].start_point.level == level) {
-      Location end = get_endpoint(nav[i]);
-      draw_line(
-        buffer,
-        img_width,
-        img_height,
-        TO_PX_X(nav[i].start_point.x),
-        TO_PX_Y(nav[i].start_point.y),
-        TO_PX_X(end.x),
-        TO_PX_Y(end.y),
-        COLOR_RED,
-        pixels_per_unit / 3
-      );
+// the tiles from first to last that pixels from min to max fall in; 0 if there are none
+static int tile_span(double min, double max, int size, int tile_count, int *first, int *last) {
+  double end = (double)size * tile_count;
+  if (isnan(min) || isnan(max)) {
+    // nowhere sensible; let every tile try it like the whole image used to
+    *first = 0;
+    *last = tile_count - 1;
+    return 1;
+  }
+  if (max < 0 || min >= end) return 0;
+  *first = min <= 0 ? 0 : (int)(min / size);
+  *last = max >= end ? tile_count - 1 : (int)(max / size);
+  return 1;
+}
+
+// sorts the items into the tiles they can touch, keeping them in drawing order within each tile
+static void bin_items(LevelRender *render, int item_count) {
+  int tile_count = render->tile_columns * render->tile_rows;
+  render->tile_start = calloc(tile_count + 1, sizeof(int));
+  int *cursor = malloc(sizeof(int) * (tile_count + 1));
+
+  // first count the items per tile, then fill them in at the offsets that gives
+  for (int pass = 0; pass < 2; pass++) {
+    for (int i = 0; i < item_count; i++) {
+      double min_x, min_y, max_x, max_y;
+      int first_column, last_column, first_row, last_row;
+      item_bounds(render, render->items[i], &min_x, &min_y, &max_x, &max_y);
+      if (!tile_span(min_x, max_x, render->tile_width, render->tile_columns, &first_column, &last_column)) continue;
+      if (!tile_span(min_y, max_y, render->tile_height, render->tile_rows, &first_row, &last_row)) continue;
+      for (int row = first_row; row <= last_row; row++) {
+        for (int column = first_column; column <= last_column; column++) {
+          int tile = row * render->tile_columns + column;
+          if (pass == 0) render->tile_start[tile + 1]++;
+          else render->tile_items[cursor[tile]++] = i;
+        }
+      }
+    }
+    if (pass == 0) {
+      for (int t = 0; t < tile_count; t++) {
+        render->tile_start[t + 1] += render->tile_start[t];
+        cursor[t] = render->tile_start[t];
+      }
+      render->tile_items = malloc(sizeof(int) * (render->tile_start[tile_count] + 1));
     }
   }
+  free(cursor);
+}
 
-  // Draw spaces
-  for (int i = 0; i < lot.space_count; i++) {
-    if (lot.spaces[i].location.level == level) {
-      Rectangle world_rect = get_space_rectangle(lot.spaces[i]);
-      Rectangle pixel_rect = world_to_pixel_rect(world_rect, pixels_per_unit, min_x, max_y);
-      Color fill = get_space_color(lot.spaces[i].type);
-      draw_rectangle(buffer, img_width, img_height, pixel_rect, &fill, &COLOR_BLACK, 2);
-      draw_space_label(buffer, img_width, img_height, pixel_rect, lot.spaces[i].name);
+// draws everything that touches one tile, in the same order as for the whole image,
+// so every pixel goes through exactly the same blends as it would without tiles
+static void render_tile(void *argument) {
+  const TileTask *task = argument;
+  const LevelRender *render = task->render;
+  const Canvas *image = &render->image;
+  int column = task->tile % render->tile_columns;
+  int row = task->tile / render->tile_columns;
+  Canvas canvas = *image;
+  canvas.min_x = column * render->tile_width;
+  canvas.min_y = row * render->tile_height;
+  canvas.max_x = canvas.min_x + render->tile_width < image->width ? canvas.min_x + render->tile_width : image->width;
+  canvas.max_y = canvas.min_y + render->tile_height < image->height ? canvas.min_y + render->tile_height : image->height;
+
+  for (int y = canvas.min_y; y < canvas.max_y; y++) {
+    for (int x = canvas.min_x; x < canvas.max_x; x++) {
+      canvas.buffer[y * canvas.width + x] = COLOR_BACKGROUND;
     }
   }
 
-  // Draw entrance
-  if (lot.entrance.level == level) {
-    draw_circle(buffer, img_width, img_height,
-                TO_PX_X(lot.entrance.x), TO_PX_Y(lot.entrance.y),
-                pixels_per_unit * 0.8, &COLOR_ENTRANCE, &COLOR_BLACK, 0);
+  for (int i = 0; i < canvas.width; i++) {
+    set_pixel(&canvas, i, 0, COLOR_BLACK);
+    set_pixel(&canvas, i, canvas.height - 1, COLOR_BLACK);
+  }
+  for (int i = 0; i < canvas.height; i++) {
+    set_pixel(&canvas, 0, i, COLOR_BLACK);
+    set_pixel(&canvas, canvas.width - 1, i, COLOR_BLACK);
   }
 
-  // Draw POI
-  if (lot.POI.level == level) {
-    draw_circle(buffer, img_width, img_height,
-                TO_PX_X(lot.POI.x), TO_PX_Y(lot.POI.y),
-                pixels_per_unit * 0.6, &COLOR_POI, &COLOR_BLACK, 0);
+  for (int k = render->tile_start[task->tile]; k < render->tile_start[task->tile + 1]; k++) {
+    draw_item(render, &canvas, render->items[render->tile_items[k]]);
   }
 
-  // Draw ups
-  for (int i = 0; i < lot.up_count; i++) {
-    if (lot.ups[i].level == level) {
-      draw_circle(buffer, img_width, img_height,
-                  TO_PX_X(lot.ups[i].x), TO_PX_Y(lot.ups[i].y),
-                  pixels_per_unit * 0.5, &COLOR_UP, &COLOR_BLACK, 0);
-    }
+  canvas_scale_bar(&canvas, render->pixels_per_unit, 15);
+  canvas_level_label(&canvas, render->level, 15);
+}
+
+// where a level's image starts in the world and how many pixels it is; the size is not positive if the level is empty
+static void level_frame(const Lot lot, const LevelTable *levels, int level, int pixels_per_unit, double *min_x, double *max_y, int *width, int *height) {
+  double min_y, max_x;
+  calculate_lot_bounds(lot, levels, level, min_x, &min_y, &max_x, max_y);
+  *width = (int)((max_x - *min_x) * pixels_per_unit);
+  *height = (int)((*max_y - min_y) * pixels_per_unit);
+}
+
+// renders a level into a new buffer, tile by tile on the pool, or all in one go without one
+// returns NULL if the level has no pixels
+static Color *render_level(const Lot lot, int level, int pixels_per_unit, const Path *nav, int nav_count, ThreadPool *pool, int *out_width, int *out_height) {
+  // lots built by hand get their level buckets just for this
+  LevelTable *levels = lot.levels ? lot.levels : build_level_table(lot);
+  int space_count, path_count;
+  const int *spaces = level_spaces(levels, level, &space_count);
+  const int *paths = level_paths(levels, level, &path_count);
+
+  double min_x, max_y;
+  int img_width, img_height;
+  level_frame(lot, levels, level, pixels_per_unit, &min_x, &max_y, &img_width, &img_height);
+
+  Color *buffer = img_width > 0 && img_height > 0 ? malloc(img_width * img_height * sizeof(Color)) : NULL;
+  if (!buffer) {
+    if (levels != lot.levels) free_level_table(levels);
+    return NULL;
   }
 
-  // Draw downs
+  // paths, then the nav route, then spaces, then the entrance, POI, ups and downs on top
+  DrawItem *items = malloc(sizeof(DrawItem) * (path_count + nav_count + space_count + 2 + lot.up_count + lot.down_count));
+  int item_count = 0;
+  for (int k = 0; k < path_count; k++) items[item_count++] = (DrawItem){ DrawPath, paths[k] };
+  for (int i = 0; i < nav_count; i++) {
+    if (nav[i].start_point.level == level) items[item_count++] = (DrawItem){ DrawNav, i };
+  }
+  for (int k = 0; k < space_count; k++) items[item_count++] = (DrawItem){ DrawSpace, spaces[k] };
+  if (lot.entrance.level == level) items[item_count++] = (DrawItem){ DrawEntrance, 0 };
+  if (lot.POI.level == level) items[item_count++] = (DrawItem){ DrawPOI, 0 };
+  for (int i = 0; i < lot.up_count; i++) {
+    if (lot.ups[i].level == level) items[item_count++] = (DrawItem){ DrawUp, i };
+  }
   for (int i = 0; i < lot.down_count; i++) {
-    if (lot.downs[i].level == level) {
-      draw_circle(buffer, img_width, img_height,
-                  TO_PX_X(lot.downs[i].x), TO_PX_Y(lot.downs[i].y),
-                  pixels_per_unit * 0.5, &COLOR_DOWN, &COLOR_BLACK, 0);
-    }
+    if (lot.downs[i].level == level) items[item_count++] = (DrawItem){ DrawDown, i };
   }
+  if (levels != lot.levels) free_level_table(levels);
+
+  LevelRender render = {
+    .lot = lot,
+    .level = level,
+    .pixels_per_unit = pixels_per_unit,
+    .nav = nav,
+    .min_x = min_x,
+    .max_y = max_y,
+    .image = image_canvas(buffer, img_width, img_height),
+    .items = items
+  };
+  // without a pool the whole image is a single tile
+  render.tile_width = pool ? tile_size : img_width;
+  render.tile_height = pool ? tile_size : img_height;
+  render.tile_columns = (img_width + render.tile_width - 1) / render.tile_width;
+  render.tile_rows = (img_height + render.tile_height - 1) / render.tile_height;
+  bin_items(&render, item_count);
+
+  int tile_count = render.tile_columns * render.tile_rows;
+  TileTask *tasks = malloc(sizeof(TileTask) * tile_count);
+  for (int t = 0; t < tile_count; t++) {
+    tasks[t] = (TileTask){ &render, t };
+    if (pool) thread_pool_submit(pool, render_tile, &tasks[t]);
+  }
+  if (pool) thread_pool_wait(pool);
+  else render_tile(&tasks[0]);
+
+  free(tasks);
+  free(render.tile_start);
+  free(render.tile_items);
+  free(items);
+  *out_width = img_width;
+  *out_height = img_height;
+  return buffer;
+}
+
+// Main function to render a lot level to a PPM image file
+// Combines the various drawing functions defined above
+// using them to draw all components of the lot
+int lot_to_ppm(const Lot lot, const char *filename, int level, int pixels_per_unit, Path* nav, int nav_count) {
+  return lot_to_ppm_parallel(lot, filename, level, pixels_per_unit, nav, nav_count, NULL);
+}
 
-  #undef TO_PX_X
-  #undef TO_PX_Y
+// same as lot_to_ppm, but the tiles of the image are rasterised on the pool; the image is byte for byte the same
+int lot_to_ppm_parallel(const Lot lot, const char *filename, int level, int pixels_per_unit, Path* nav, int nav_count, ThreadPool* pool) {
+  if (!filename || pixels_per_unit <= 0) return -1;
 
-  draw_scale_bar(buffer, img_width, img_height, pixels_per_unit, 15);
-  draw_level_label(buffer, img_width, img_height, level, 15);
+  int img_width, img_height;
+  Color *buffer = render_level(lot, level, pixels_per_unit, nav, nav_count, pool, &img_width, &img_height);
+  if (!buffer) return -1;
 
   FILE *fp = fopen(filename, "wb");
   if (!fp) {
@@ -862,3 +1101,86 @@ int lot_to_ppm_all_levels(const Lot lot, const char *base_filename, int pixels_p
   }
   return 0;
 }
+
+// how many bytes of images the levels being rendered may hold at once
+typedef struct {
+  pthread_mutex_t lock;
+  pthread_cond_t released;
+  size_t budget;
+  size_t in_use;   // bytes held by the levels being rendered
+  int rendering;   // how many levels are being rendered
+  int failed;
+} ImageBudget;
+
+typedef struct {
+  Lot lot;
+  const char *base_filename;
+  int pixels_per_unit;
+  Path *nav;
+  int nav_count;
+  ImageBudget *budget;
+} AllLevelsRender;
+
+typedef struct {
+  const AllLevelsRender *render;
+  int level;
+  size_t bytes;
+} LevelTask;
+
+// renders one level once its image fits in the budget
+// a level that would not fit even on its own still gets rendered, just with nothing else alongside it
+static void render_level_task(void *argument) {
+  const LevelTask *task = argument;
+  const AllLevelsRender *render = task->render;
+  ImageBudget *budget = render->budget;
+
+  pthread_mutex_lock(&budget->lock);
+  while (budget->rendering > 0 && budget->in_use + task->bytes > budget->budget) {
+    pthread_cond_wait(&budget->released, &budget->lock);
+  }
+  budget->in_use += task->bytes;
+  budget->rendering++;
+  pthread_mutex_unlock(&budget->lock);
+
+  char filename[256];
+  snprintf(filename, sizeof(filename), "%s_level%d.ppm", render->base_filename, task->level);
+  // the pool is busy with the levels themselves, so each level is drawn in one go
+  int failed = lot_to_ppm(render->lot, filename, task->level, render->pixels_per_unit, render->nav, render->nav_count) != 0;
+
+  pthread_mutex_lock(&budget->lock);
+  budget->in_use -= task->bytes;
+  budget->rendering--;
+  if (failed) budget->failed = 1;
+  pthread_cond_broadcast(&budget->released);
+  pthread_mutex_unlock(&budget->lock);
+}
+
+// every level is a task on the pool; the size of its image is known up front, so it can wait its turn for the budget
+int lot_to_ppm_all_levels_parallel(const Lot lot, const char *base_filename, int pixels_per_unit, Path* nav, int nav_count, ThreadPool* pool, size_t memory_budget) {
+  if (!base_filename) return -1;
+
+  // the level buckets are shared by every level, so lots built by hand get them once up front
+  LevelTable *built_levels = lot.levels ? NULL : build_level_table(lot);
+  ImageBudget budget = { .budget = memory_budget };
+  pthread_mutex_init(&budget.lock, NULL);
+  pthread_cond_init(&budget.released, NULL);
+  AllLevelsRender render = { lot, base_filename, pixels_per_unit, nav, nav_count, &budget };
+  if (built_levels) render.lot.levels = built_levels;
+
+  LevelTask *tasks = malloc(sizeof(LevelTask) * (lot.level_count + 1));
+  for (int level = 0; level < lot.level_count; level++) {
+    double min_x, max_y;
+    int width, height;
+    level_frame(render.lot, render.lot.levels, level, pixels_per_unit, &min_x, &max_y, &width, &height);
+    size_t bytes = width > 0 && height > 0 ? (size_t)width * height * sizeof(Color) : 0;
+    tasks[level] = (LevelTask){ &render, level, bytes };
+    thread_pool_submit(pool, render_level_task, &tasks[level]);
+  }
+  thread_pool_wait(pool);
+
+  free(tasks);
+  free_level_table(built_levels);
+  pthread_mutex_destroy(&budget.lock);
+  pthread_cond_destroy(&budget.released);
+  return budget.failed ? -1 : 0;
+}
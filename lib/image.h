@@ -1,5 +1,7 @@
 #pragma once
 #include <data.h>
+#include <threadPool.h>
+#include <stddef.h>
 
 // Color structure for RGB pixels
 typedef struct {
@@ -61,8 +63,21 @@ void draw_scale_bar(Color *buffer, int img_width, int img_height,
  */
 int lot_to_ppm(const Lot lot, const char *filename, int level, int pixels_per_unit, Path* nav, int nav_count);
 
+/**
+ * Same as lot_to_ppm, but the image is split into tiles that are rasterised on the pool.
+ * The file is byte for byte the same.
+ */
+int lot_to_ppm_parallel(const Lot lot, const char *filename, int level, int pixels_per_unit, Path* nav, int nav_count, ThreadPool* pool);
+
 /**
  * Write all levels of a Lot to separate PPM files. 
  */
 int lot_to_ppm_all_levels(const Lot lot, const char *base_filename, int pixels_per_unit, Path* nav, int nav_count);
 
+/**
+ * Same as lot_to_ppm_all_levels, but the levels are rendered side by side on the pool,
+ * holding no more than memory_budget bytes of images at once (a bigger level is rendered on its own).
+ * Every level that can be rendered is written, even if another one fails.
+ */
+int lot_to_ppm_all_levels_parallel(const Lot lot, const char *base_filename, int pixels_per_unit, Path* nav, int nav_count, ThreadPool* pool, size_t memory_budget);
+
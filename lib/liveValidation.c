@@ -0,0 +1,582 @@
+#include "liveValidation.h"
+#include "calculations.h"
+#include "data.h"
+#include "lot.h"
+#include "spatial.h"
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// === Movable index ===
+// per level trees over boxes that can move. the trees keep every item as it was when they were built;
+// an item that changed since then is flagged as moved, its tree entry is ignored and it is kept on a
+// short pending list that every query searches one by one. once that list gets long the trees are rebuilt.
+
+typedef struct {
+  Aabb *boxes;
+  int *levels;
+  char *present;  // 0 for items that are gone (or never go in, like zero length paths)
+  char *moved;    // 1 if the trees' copy of the item is out of date
+  int count;
+  int capacity;
+  int min_level;
+  int level_span;
+  AabbTree *trees; // tree over the items on level min_level + l
+  int *pending;    // every moved item that was present when it moved
+  int pending_count;
+} MovableIndex;
+
+static void grow_movable_index(MovableIndex *index, int count) {
+  if (count <= index->capacity) return;
+  while (index->capacity < count) index->capacity = index->capacity ? 2 * index->capacity : 16;
+  index->boxes = realloc(index->boxes, sizeof(Aabb) * index->capacity);
+  index->levels = realloc(index->levels, sizeof(int) * index->capacity);
+  index->present = realloc(index->present, index->capacity);
+  index->moved = realloc(index->moved, index->capacity);
+  index->pending = realloc(index->pending, sizeof(int) * index->capacity);
+}
+
+static void free_movable_trees(MovableIndex *index) {
+  for (int l = 0; l < index->level_span; l++) free_aabb_tree(index->trees[l]);
+  free(index->trees);
+  index->trees = NULL;
+  index->level_span = 0;
+}
+
+static void rebuild_movable_index(MovableIndex *index) {
+  free_movable_trees(index);
+  int first = 1, max_level = 0;
+  for (int i = 0; i < index->count; i++) {
+    index->moved[i] = 0;
+    if (!index->present[i]) continue;
+    if (first || index->levels[i] < index->min_level) index->min_level = index->levels[i];
+    if (first || index->levels[i] > max_level) max_level = index->levels[i];
+    first = 0;
+  }
+  index->pending_count = 0;
+  if (first) return; // nothing left to index
+
+  // bucket the items by level, then build one tree per bucket
+  index->level_span = max_level - index->min_level + 1;
+  int *level_start = calloc(index->level_span + 1, sizeof(int));
+  int *items = malloc(sizeof(int) * index->count);
+  for (int i = 0; i < index->count; i++) {
+    if (index->present[i]) level_start[index->levels[i] - index->min_level + 1]++;
+  }
+  for (int l = 0; l < index->level_span; l++) level_start[l + 1] += level_start[l];
+  int *fill = malloc(sizeof(int) * index->level_span);
+  memcpy(fill, level_start, sizeof(int) * index->level_span);
+  for (int i = 0; i < index->count; i++) {
+    if (index->present[i]) items[fill[index->levels[i] - index->min_level]++] = i;
+  }
+  index->trees = malloc(sizeof(AabbTree) * index->level_span);
+  for (int l = 0; l < index->level_span; l++) {
+    index->trees[l] = build_aabb_tree(index->boxes, items + level_start[l], level_start[l + 1] - level_start[l]);
+  }
+  free(fill);
+  free(items);
+  free(level_start);
+}
+
+// put an item (back) in the index with a new box; item may be one past the end to add it
+static void place_movable_item(MovableIndex *index, int item, Aabb box, int level, int present) {
+  if (item == index->count) {
+    grow_movable_index(index, item + 1);
+    index->count++;
+    index->moved[item] = 0;
+  }
+  index->boxes[item] = box;
+  index->levels[item] = level;
+  index->present[item] = present;
+  if (!index->moved[item]) {
+    index->moved[item] = 1;
+    if (present) index->pending[index->pending_count++] = item;
+  } else if (present) {
+    // it is not on the pending list if it was left out of the index the last time it moved
+    int listed = 0;
+    for (int k = 0; k < index->pending_count && !listed; k++) listed = index->pending[k] == item;
+    if (!listed) index->pending[index->pending_count++] = item;
+  }
+}
+
+// rebuild the trees once the pending list costs more to search than a tree query
+static void settle_movable_index(MovableIndex *index) {
+  if (index->pending_count > 32 + index->count / 16) rebuild_movable_index(index);
+}
+
+static void remove_movable_item(MovableIndex *index, int item) {
+  index->present[item] = 0;
+  index->moved[item] = 1;
+}
+
+static void free_movable_index(MovableIndex *index) {
+  free_movable_trees(index);
+  free(index->boxes);
+  free(index->levels);
+  free(index->present);
+  free(index->moved);
+  free(index->pending);
+}
+
+typedef struct {
+  const MovableIndex *index;
+  int *out;
+  int count;
+} MovableQuery;
+
+static int collect_unmoved(int item, void *context) {
+  MovableQuery *query = context;
+  if (!query->index->moved[item]) query->out[query->count++] = item;
+  return 0;
+}
+
+// write every present item on a level whose box overlaps box into out (room for every item) and return how many
+static int movable_index_query(const MovableIndex *index, Aabb box, int level, int *out) {
+  MovableQuery query = { index, out, 0 };
+  int l = level - index->min_level;
+  if (l >= 0 && l < index->level_span) {
+    aabb_tree_query(&index->trees[l], index->boxes, box, collect_unmoved, &query);
+  }
+  for (int k = 0; k < index->pending_count; k++) {
+    int item = index->pending[k];
+    if (index->present[item] && index->levels[item] == level && aabbs_overlap(index->boxes[item], box)) {
+      out[query.count++] = item;
+    }
+  }
+  return query.count;
+}
+
+// === Name counts ===
+// how many present spaces carry each name, in an open addressing table keyed by the name
+
+typedef struct {
+  char *name; // a copy, NULL for an empty slot
+  int count;
+} NameCount;
+
+typedef struct {
+  NameCount *slots;
+  int slot_count; // always a power of two
+  int used;
+} NameCounts;
+
+static NameCount *find_name(NameCounts *names, const char *name) {
+  int mask = names->slot_count - 1;
+  int slot = (int)(hash_name(name) & (uint64_t)mask);
+  while (names->slots[slot].name && strcmp(names->slots[slot].name, name) != 0) {
+    slot = (slot + 1) & mask; // linear probing
+  }
+  return &names->slots[slot];
+}
+
+// add delta to the count of a name and return the new count
+static int count_name(NameCounts *names, const char *name, int delta) {
+  // the table is kept at most half full so probe sequences stay short
+  if (2 * (names->used + 1) > names->slot_count) {
+    NameCounts grown = { calloc(names->slot_count ? 2 * names->slot_count : 64, sizeof(NameCount)), 0, 0 };
+    grown.slot_count = names->slot_count ? 2 * names->slot_count : 64;
+    for (int i = 0; i < names->slot_count; i++) {
+      if (!names->slots[i].name) continue;
+      if (names->slots[i].count == 0) {
+        free(names->slots[i].name); // names nobody uses any more are dropped on the way
+        continue;
+      }
+      *find_name(&grown, names->slots[i].name) = names->slots[i];
+      grown.used++;
+    }
+    free(names->slots);
+    *names = grown;
+  }
+  NameCount *entry = find_name(names, name);
+  if (!entry->name) {
+    entry->name = strdup(name);
+    names->used++;
+  }
+  entry->count += delta;
+  return entry->count;
+}
+
+static void free_name_counts(NameCounts *names) {
+  for (int i = 0; i < names->slot_count; i++) free(names->slots[i].name);
+  free(names->slots);
+}
+
+// === Live validation ===
+
+struct LiveValidation {
+  Lot lot;                 // spaces, paths, ups and downs are owned here (names too); removed ones stay as gaps
+  int space_capacity;
+  int path_capacity;
+  char *removed_paths;     // 1 for the gaps among the paths
+  SpaceGeometry *geometry; // of every space
+  Rectangle *clearance;    // corridor of every path at path_clearance
+  Rectangle *access;       // and at path_accessibility
+  MovableIndex spaces;     // bounding box of every space
+  MovableIndex corridors;  // bounding box of every access corridor, which holds the clearance corridor too
+  int *overlaps;           // per space, how many spaces it overlaps
+  int *encroached;         // per space, how many clearance corridors it touches
+  int *reachable;          // per space, how many access corridors it touches
+  int *candidates;         // scratch room for index queries
+  NameCounts names;
+
+  // how many things break each rule
+  int zero_length_paths;
+  int paths_disconnected;
+  long long overlapping_pairs;
+  long long encroachments;
+  int inaccessible_spaces;
+  int invalid_entrance_or_poi;
+  int duplicate_names;
+  int wrong_up_down_count;
+  int levels_missing_ups_or_downs;
+  int too_long_names;
+};
+
+static int is_zero_length(const Path path) {
+  return sqrt(path.vector.x * path.vector.x + path.vector.y * path.vector.y) < DBL_EPSILON;
+}
+
+static Aabb rectangle_box(Rectangle rect) {
+  Vector min = rect.corner[0], max = rect.corner[0];
+  for (int c = 1; c < 4; c++) {
+    min.x = fmin(min.x, rect.corner[c].x);
+    min.y = fmin(min.y, rect.corner[c].y);
+    max.x = fmax(max.x, rect.corner[c].x);
+    max.y = fmax(max.y, rect.corner[c].y);
+  }
+  return aabb_with_slack(min, max);
+}
+
+static void grow_spaces(LiveValidation *live, int count) {
+  if (count <= live->space_capacity) return;
+  while (live->space_capacity < count) live->space_capacity = live->space_capacity ? 2 * live->space_capacity : 16;
+  live->lot.spaces = realloc(live->lot.spaces, sizeof(Space) * live->space_capacity);
+  live->geometry = realloc(live->geometry, sizeof(SpaceGeometry) * live->space_capacity);
+  live->overlaps = realloc(live->overlaps, sizeof(int) * live->space_capacity);
+  live->encroached = realloc(live->encroached, sizeof(int) * live->space_capacity);
+  live->reachable = realloc(live->reachable, sizeof(int) * live->space_capacity);
+  int candidates = live->space_capacity > live->path_capacity ? live->space_capacity : live->path_capacity;
+  live->candidates = realloc(live->candidates, sizeof(int) * candidates);
+}
+
+static void grow_paths(LiveValidation *live, int count) {
+  if (count <= live->path_capacity) return;
+  while (live->path_capacity < count) live->path_capacity = live->path_capacity ? 2 * live->path_capacity : 16;
+  live->lot.paths = realloc(live->lot.paths, sizeof(Path) * live->path_capacity);
+  live->removed_paths = realloc(live->removed_paths, live->path_capacity);
+  live->clearance = realloc(live->clearance, sizeof(Rectangle) * live->path_capacity);
+  live->access = realloc(live->access, sizeof(Rectangle) * live->path_capacity);
+  int candidates = live->space_capacity > live->path_capacity ? live->space_capacity : live->path_capacity;
+  live->candidates = realloc(live->candidates, sizeof(int) * candidates);
+}
+
+// set (or reset) the space in slot i and its entry in the space index, without counting anything
+static void place_space(LiveValidation *live, int i, Space space) {
+  live->lot.spaces[i] = space;
+  live->geometry[i] = get_space_geometry(space);
+  place_movable_item(&live->spaces, i, aabb_with_slack(live->geometry[i].min, live->geometry[i].max), space.location.level, 1);
+}
+
+// set (or reset) the path in slot p and its entry in the corridor index, without counting anything
+// zero length paths have no direction, so they get no corridor and stay out of the index
+static void place_path(LiveValidation *live, int p, Path path) {
+  live->lot.paths[p] = path;
+  live->removed_paths[p] = 0;
+  int zero = is_zero_length(path);
+  if (!zero) {
+    live->clearance[p] = get_path_corridor(path, path_clearance);
+    live->access[p] = get_path_corridor(path, path_accessibility);
+  }
+  Aabb box = zero ? (Aabb){ { 0, 0 }, { 0, 0 } } : rectangle_box(live->access[p]);
+  place_movable_item(&live->corridors, p, box, path.start_point.level, !zero);
+}
+
+// count (sign 1) or uncount (sign -1) the overlaps of space i with every other space
+static void count_space_overlaps(LiveValidation *live, int i, int sign) {
+  int count = movable_index_query(&live->spaces, live->spaces.boxes[i], live->spaces.levels[i], live->candidates);
+  for (int k = 0; k < count; k++) {
+    int j = live->candidates[k];
+    if (j == i || separating_axis(live->geometry[i].rect, live->geometry[j].rect)) continue;
+    live->overlaps[i] += sign;
+    live->overlaps[j] += sign;
+    live->overlapping_pairs += sign;
+  }
+}
+
+// count the corridors space i touches from scratch
+static void count_space_corridors(LiveValidation *live, int i) {
+  int count = movable_index_query(&live->corridors, live->spaces.boxes[i], live->spaces.levels[i], live->candidates);
+  live->encroached[i] = 0;
+  live->reachable[i] = 0;
+  for (int k = 0; k < count; k++) {
+    int p = live->candidates[k];
+    if (!separating_axis(live->geometry[i].rect, live->clearance[p])) live->encroached[i]++;
+    if (!separating_axis(live->geometry[i].rect, live->access[p])) live->reachable[i]++;
+  }
+  live->encroachments += live->encroached[i];
+  if (live->reachable[i] == 0) live->inaccessible_spaces++;
+}
+
+static void uncount_space_corridors(LiveValidation *live, int i) {
+  live->encroachments -= live->encroached[i];
+  if (live->reachable[i] == 0) live->inaccessible_spaces--;
+}
+
+static void count_space_name(LiveValidation *live, int i, int sign) {
+  const char *name = live->lot.spaces[i].name;
+  int count = count_name(&live->names, name, sign);
+  // every space past the first with a name is one duplicate
+  if (sign > 0 && count > 1) live->duplicate_names++;
+  if (sign < 0 && count > 0) live->duplicate_names--;
+  if (strlen(name) > 10) live->too_long_names += sign;
+}
+
+// count (sign 1) or uncount (sign -1) what path p does to the spaces around it
+static void count_path(LiveValidation *live, int p, int sign) {
+  const Path path = live->lot.paths[p];
+  if (is_zero_length(path)) {
+    live->zero_length_paths += sign;
+    return;
+  }
+  int count = movable_index_query(&live->spaces, live->corridors.boxes[p], path.start_point.level, live->candidates);
+  for (int k = 0; k < count; k++) {
+    int i = live->candidates[k];
+    if (!separating_axis(live->geometry[i].rect, live->clearance[p])) {
+      live->encroached[i] += sign;
+      live->encroachments += sign;
+    }
+    if (!separating_axis(live->geometry[i].rect, live->access[p])) {
+      if (live->reachable[i] == 0) live->inaccessible_spaces--;
+      live->reachable[i] += sign;
+      if (live->reachable[i] == 0) live->inaccessible_spaces++;
+    }
+  }
+}
+
+// connectivity is about every path at once, so it is checked again over the paths that are left
+// (it only looks at where paths start and end, which is cheap next to the geometry)
+static void recheck_connectivity(LiveValidation *live) {
+  Lot lot = live->lot;
+  lot.paths = malloc(sizeof(Path) * (live->lot.path_count + 1));
+  lot.path_count = 0;
+  for (int p = 0; p < live->lot.path_count; p++) {
+    if (!live->removed_paths[p]) lot.paths[lot.path_count++] = live->lot.paths[p];
+  }
+  live->paths_disconnected = !paths_connected(lot);
+  free(lot.paths);
+}
+
+static int path_exists(const LiveValidation *live, int p) {
+  return p >= 0 && p < live->lot.path_count && !live->removed_paths[p];
+}
+
+// keep track of every path and space in a lot, and check it once in full
+LiveValidation *create_live_validation(const Lot lot) {
+  LiveValidation *live = calloc(1, sizeof(LiveValidation));
+  live->lot = lot;
+  live->lot.spaces = NULL;
+  live->lot.paths = NULL;
+  live->lot.space_count = 0;
+  live->lot.path_count = 0;
+  // none of the lot's indexes would follow the changes
+  live->lot.routes = NULL;
+  live->lot.free_spaces = NULL;
+  live->lot.parked = NULL;
+  live->lot.columns = NULL;
+  live->lot.levels = NULL;
+  live->lot.geometry = NULL;
+  live->lot.clearance_corridors = NULL;
+  live->lot.access_corridors = NULL;
+  live->lot.names = NULL;
+  live->lot.mapping = NULL;
+  live->lot.mapping_size = 0;
+  live->lot.ups = malloc(sizeof(Location) * (lot.up_count + 1));
+  live->lot.downs = malloc(sizeof(Location) * (lot.down_count + 1));
+  memcpy(live->lot.ups, lot.ups, sizeof(Location) * lot.up_count);
+  memcpy(live->lot.downs, lot.downs, sizeof(Location) * lot.down_count);
+
+  grow_spaces(live, lot.space_count);
+  grow_paths(live, lot.path_count);
+  for (int i = 0; i < lot.space_count; i++) {
+    Space space = lot.spaces[i];
+    space.name = strdup(space.name);
+    place_space(live, i, space);
+  }
+  live->lot.space_count = lot.space_count;
+  for (int p = 0; p < lot.path_count; p++) {
+    place_path(live, p, lot.paths[p]);
+  }
+  live->lot.path_count = lot.path_count;
+  rebuild_movable_index(&live->spaces);
+  rebuild_movable_index(&live->corridors);
+
+  // every pair of spaces turns up twice here, once from either side
+  for (int i = 0; i < lot.space_count; i++) {
+    int count = movable_index_query(&live->spaces, live->spaces.boxes[i], live->spaces.levels[i], live->candidates);
+    live->overlaps[i] = 0;
+    for (int k = 0; k < count; k++) {
+      int j = live->candidates[k];
+      if (j != i && !separating_axis(live->geometry[i].rect, live->geometry[j].rect)) live->overlaps[i]++;
+    }
+    live->overlapping_pairs += live->overlaps[i];
+    count_space_corridors(live, i);
+    count_space_name(live, i, 1);
+  }
+  live->overlapping_pairs /= 2;
+  for (int p = 0; p < lot.path_count; p++) {
+    if (is_zero_length(lot.paths[p])) live->zero_length_paths++;
+  }
+  recheck_connectivity(live);
+
+  // nothing below changes with the spaces or paths, so these are checked once
+  live->invalid_entrance_or_poi = !has_valid_entrance_and_poi(live->lot);
+  live->wrong_up_down_count = !has_correct_up_down_count(live->lot);
+  live->levels_missing_ups_or_downs = !levels_have_ups_and_downs(live->lot);
+  return live;
+}
+
+void free_live_validation(LiveValidation *live) {
+  if (!live) return;
+  for (int i = 0; i < live->lot.space_count; i++) {
+    if (live->spaces.present[i]) free(live->lot.spaces[i].name);
+  }
+  free(live->lot.spaces);
+  free(live->lot.paths);
+  free(live->lot.ups);
+  free(live->lot.downs);
+  free(live->removed_paths);
+  free(live->geometry);
+  free(live->clearance);
+  free(live->access);
+  free_movable_index(&live->spaces);
+  free_movable_index(&live->corridors);
+  free(live->overlaps);
+  free(live->encroached);
+  free(live->reachable);
+  free(live->candidates);
+  free_name_counts(&live->names);
+  free(live);
+}
+
+// what validate_lot would say about the lot as it is now
+ValidationResult live_validation_result(const LiveValidation *live) {
+  int broken[VALIDATION_RULE_COUNT] = {
+    live->zero_length_paths > 0,
+    live->paths_disconnected,
+    live->overlapping_pairs > 0,
+    live->encroachments > 0,
+    live->inaccessible_spaces > 0,
+    live->invalid_entrance_or_poi,
+    live->duplicate_names > 0,
+    live->wrong_up_down_count,
+    live->levels_missing_ups_or_downs,
+    live->too_long_names > 0
+  };
+  static const LotValidationError errors[VALIDATION_RULE_COUNT] = {
+    ZeroLengthPath, PathNotConnected, SpacesOverlap, SpacesEncroachPath, SpacesInaccessible,
+    InvalidEntranceOrPOI, DuplicateSpaceNames, IncorrectUpDownCount, LevelsMissingUpsOrDowns, SpaceNameTooLong
+  };
+  for (int rule = 0; rule < VALIDATION_RULE_COUNT; rule++) {
+    if (broken[rule]) return (ValidationResult){ Err, errors[rule] };
+  }
+  return (ValidationResult){ Ok, NoError };
+}
+
+// a lot with the spaces and paths as they are now, with the gaps closed up (so indices can shift)
+// the space names still belong to the live validation; free the lot with free_lot before freeing that
+Lot live_validation_snapshot(const LiveValidation *live) {
+  Lot lot = create_lot(live->lot.level_count, 0, 0, live->lot.up_count, live->lot.down_count);
+  lot.spaces = realloc(lot.spaces, sizeof(Space) * (live->lot.space_count + 1));
+  lot.paths = realloc(lot.paths, sizeof(Path) * (live->lot.path_count + 1));
+  for (int i = 0; i < live->lot.space_count; i++) {
+    if (live->spaces.present[i]) lot.spaces[lot.space_count++] = live->lot.spaces[i];
+  }
+  for (int p = 0; p < live->lot.path_count; p++) {
+    if (path_exists(live, p)) lot.paths[lot.path_count++] = live->lot.paths[p];
+  }
+  memcpy(lot.ups, live->lot.ups, sizeof(Location) * live->lot.up_count);
+  memcpy(lot.downs, live->lot.downs, sizeof(Location) * live->lot.down_count);
+  lot.entrance = live->lot.entrance;
+  lot.POI = live->lot.POI;
+  lot.ramp_length = live->lot.ramp_length;
+  return lot;
+}
+
+// add a space (its name is copied) and return its index
+int live_add_space(LiveValidation *live, Space space) {
+  int i = live->lot.space_count;
+  grow_spaces(live, i + 1);
+  space.name = strdup(space.name);
+  place_space(live, i, space);
+  settle_movable_index(&live->spaces);
+  live->lot.space_count++;
+  live->overlaps[i] = 0;
+  count_space_overlaps(live, i, 1);
+  count_space_corridors(live, i);
+  count_space_name(live, i, 1);
+  return i;
+}
+
+// returns 0 if there is no such space
+int live_remove_space(LiveValidation *live, int space) {
+  if (space < 0 || space >= live->lot.space_count || !live->spaces.present[space]) return 0;
+  count_space_overlaps(live, space, -1);
+  uncount_space_corridors(live, space);
+  count_space_name(live, space, -1);
+  remove_movable_item(&live->spaces, space);
+  settle_movable_index(&live->spaces);
+  free(live->lot.spaces[space].name);
+  live->lot.spaces[space].name = NULL;
+  return 1;
+}
+
+// returns 0 if there is no such space
+int live_move_space(LiveValidation *live, int space, Location location, double rotation) {
+  if (space < 0 || space >= live->lot.space_count || !live->spaces.present[space]) return 0;
+  count_space_overlaps(live, space, -1);
+  uncount_space_corridors(live, space);
+  Space moved = live->lot.spaces[space];
+  moved.location = location;
+  moved.rotation = rotation;
+  place_space(live, space, moved);
+  settle_movable_index(&live->spaces);
+  count_space_overlaps(live, space, 1);
+  count_space_corridors(live, space);
+  return 1;
+}
+
+// add a path and return its index
+int live_add_path(LiveValidation *live, Path path) {
+  int p = live->lot.path_count;
+  grow_paths(live, p + 1);
+  place_path(live, p, path);
+  settle_movable_index(&live->corridors);
+  live->lot.path_count++;
+  count_path(live, p, 1);
+  recheck_connectivity(live);
+  return p;
+}
+
+// returns 0 if there is no such path
+int live_remove_path(LiveValidation *live, int path) {
+  if (!path_exists(live, path)) return 0;
+  count_path(live, path, -1);
+  remove_movable_item(&live->corridors, path);
+  settle_movable_index(&live->corridors);
+  live->removed_paths[path] = 1;
+  recheck_connectivity(live);
+  return 1;
+}
+
+// returns 0 if there is no such path
+int live_move_path(LiveValidation *live, int path, Path moved) {
+  if (!path_exists(live, path)) return 0;
+  count_path(live, path, -1);
+  place_path(live, path, moved);
+  settle_movable_index(&live->corridors);
+  count_path(live, path, 1);
+  recheck_connectivity(live);
+  return 1;
+}
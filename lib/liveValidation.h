@@ -0,0 +1,22 @@
+#pragma once
+#include <data.h>
+#include <validate.h>
+
+// keeps the verdict of validate_lot up to date while spaces and paths are added, removed or moved,
+// so a lot that changes while it is in use does not have to be validated from scratch every time.
+// a change only rechecks the spaces and paths around it, found through a spatial index.
+// spaces and paths keep their index for as long as they exist; removed ones leave a gap.
+// ups, downs, the entrance, the POI and the level count stay as they were in the lot it was created from.
+typedef struct LiveValidation LiveValidation;
+
+LiveValidation *create_live_validation(const Lot lot);
+void free_live_validation(LiveValidation *live);
+ValidationResult live_validation_result(const LiveValidation *live);
+Lot live_validation_snapshot(const LiveValidation *live);
+
+int live_add_space(LiveValidation *live, Space space);
+int live_remove_space(LiveValidation *live, int space);
+int live_move_space(LiveValidation *live, int space, Location location, double rotation);
+int live_add_path(LiveValidation *live, Path path);
+int live_remove_path(LiveValidation *live, int path);
+int live_move_path(LiveValidation *live, int path, Path moved);
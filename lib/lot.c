@@ -1,9 +1,11 @@
 #include "lot.h"
 #include "data.h"
 #include "nav.h"
+#include "validate.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 
 // Function to create a Lot
 Lot create_lot(int level_count, int path_count, int space_count, int up_count,
@@ -18,15 +20,40 @@ Lot create_lot(int level_count, int path_count, int space_count, int up_count,
   lot.space_count = space_count;
   lot.up_count = up_count;
   lot.down_count = down_count;
+  lot.routes = NULL;
+  lot.free_spaces = NULL;
+  lot.parked = NULL;
+  lot.columns = NULL;
+  lot.levels = NULL;
+  lot.geometry = NULL;
+  lot.clearance_corridors = NULL;
+  lot.access_corridors = NULL;
+  lot.names = NULL;
+  lot.mapping = NULL;
+  lot.mapping_size = 0;
   return lot;
 }
 
 // Function to free a Lot
 void free_lot(Lot lot) {
-  free(lot.paths);
-  free(lot.spaces);
-  free(lot.ups);
-  free(lot.downs);
+  if (lot.mapping) {
+    // the arrays of a compiled lot live inside its file mapping
+    munmap(lot.mapping, lot.mapping_size);
+  } else {
+    free(lot.paths);
+    free(lot.spaces);
+    free(lot.ups);
+    free(lot.downs);
+    free(lot.names); // every name of a loaded lot lives in this one block
+  }
+  free_route_index(lot.routes);
+  free_space_queues(lot.free_spaces);
+  free_car_space_map(lot.parked);
+  free_space_columns(lot.columns);
+  free_level_table(lot.levels);
+  free(lot.geometry);
+  free_corridor_index(lot.clearance_corridors);
+  free_corridor_index(lot.access_corridors);
 }
 
 // Function to print a Lot
@@ -80,76 +107,217 @@ Space *space_by_name(const Lot lot, const char *name) {
 // count the number of unique levels in the lot
 // this turns out to be non-trivial since levels are only indicated in locations
 int count_levels(const Lot lot) {
-  // to find the level count we must find the number of unique levels in paths
-  // and spaces
-  int level_count = 0;
-  // this ensures we have space even if EVERY location in the lot is a unique
-  // level lmao
-  int *levels = malloc(sizeof(int) * (lot.space_count + lot.path_count +
-                                      lot.up_count + lot.down_count));
+  if (lot.levels) return lot.levels->level_count;
+  LevelTable *table = build_level_table(lot);
+  int level_count = table->level_count;
+  free_level_table(table);
+  return level_count;
+}
+
+// === Free space queues ===
+
+// the space that should be handed out first: lowest route cost, then lowest index like a scan would
+static int space_before(const Lot lot, int a, int b) {
+  double cost_a = lot.routes->space_routes[a].cost;
+  double cost_b = lot.routes->space_routes[b].cost;
+  if (cost_a != cost_b) return cost_a < cost_b;
+  return a < b;
+}
+
+static void queue_push(const Lot lot, SpaceType type, int space_index) {
+  SpaceQueues *queues = lot.free_spaces;
+  int *heap = queues->heap[type];
+  int i = queues->size[type]++;
+  // sift up: move the parent down until the new space fits
+  while (i > 0) {
+    int parent = (i - 1) / 2;
+    if (!space_before(lot, space_index, heap[parent])) break;
+    heap[i] = heap[parent];
+    i = parent;
+  }
+  heap[i] = space_index;
+  queues->queued[space_index] = 1;
+}
+
+static void queue_pop(const Lot lot, SpaceType type) {
+  SpaceQueues *queues = lot.free_spaces;
+  int *heap = queues->heap[type];
+  queues->queued[heap[0]] = 0;
+  int last = heap[--queues->size[type]];
+  int size = queues->size[type];
+  int i = 0;
+  // sift down: move the better child up until the last space fits
+  while (1) {
+    int child = 2 * i + 1;
+    if (child >= size) break;
+    if (child + 1 < size && space_before(lot, heap[child + 1], heap[child])) child++;
+    if (!space_before(lot, heap[child], last)) break;
+    heap[i] = heap[child];
+    i = child;
+  }
+  if (size > 0) heap[i] = last;
+}
+
+// build the queues from the current occupancy; needs the route index of the lot
+SpaceQueues *build_space_queues(const Lot lot) {
+  SpaceQueues *queues = malloc(sizeof(SpaceQueues));
+  queues->space_count = lot.space_count;
+  queues->queued = calloc(lot.space_count + 1, sizeof(char));
+  for (int t = 0; t < 4; t++) {
+    // a space can only ever be in the heap of its own type, so this is the worst case
+    queues->heap[t] = malloc(sizeof(int) * (lot.space_count + 1));
+    queues->size[t] = 0;
+  }
+
+  Lot indexed = lot;
+  indexed.free_spaces = queues;
   for (int i = 0; i < lot.space_count; i++) {
-    int level = lot.spaces[i].location.level;
-    // check if level is already in levels
-    int found = 0;
-    for (int j = 0; j < level_count; j++) {
-      if (levels[j] == level) {
-        found = 1;
-        break;
-      }
-    }
-    if (!found) {
-      levels[level_count++] = level;
+    if (lot.spaces[i].occupied == -1 && lot.routes->space_routes[i].cost >= 0) {
+      queue_push(indexed, lot.spaces[i].type, i);
     }
   }
-  for (int i = 0; i < lot.path_count; i++) {
-    int level = lot.paths[i].start_point.level;
-    // check if level is already in levels
-    int found = 0;
-    for (int j = 0; j < level_count; j++) {
-      if (levels[j] == level) {
-        found = 1;
-        break;
-      }
-    }
-    if (!found) {
-      levels[level_count++] = level;
-    }
+  return queues;
+}
+
+void free_space_queues(SpaceQueues *queues) {
+  if (!queues) return;
+  for (int t = 0; t < 4; t++) {
+    free(queues->heap[t]);
   }
-  for (int i = 0; i < lot.up_count; i++) {
-    int level = lot.ups[i].level;
-    // check if level is already in levels
-    int found = 0;
-    for (int j = 0; j < level_count; j++) {
-      if (levels[j] == level) {
-        found = 1;
-        break;
-      }
-    }
-    if (!found) {
-      levels[level_count++] = level;
-    }
+  free(queues->queued);
+  free(queues);
+}
+
+// === Car to space map ===
+
+// make sure the map has room for a car index; grows geometrically since car indices come from the PlateDB
+static void ensure_car_capacity(CarSpaceMap *map, int car_index) {
+  if (car_index < map->capacity) return;
+  int capacity = map->capacity > 0 ? map->capacity : 64;
+  while (capacity <= car_index) capacity *= 2;
+  int *space_of = realloc(map->space_of, sizeof(int) * capacity);
+  if (!space_of) {
+    printf("ERROR: Memory reallocation failed!\n");
+    exit(1);
   }
-  for (int i = 0; i < lot.down_count; i++) {
-    int level = lot.downs[i].level;
-    // check if level is already in levels
-    int found = 0;
-    for (int j = 0; j < level_count; j++) {
-      if (levels[j] == level) {
-        found = 1;
-        break;
-      }
+  for (int i = map->capacity; i < capacity; i++) space_of[i] = -1;
+  map->space_of = space_of;
+  map->capacity = capacity;
+}
+
+// build the car to space map from the current occupancy
+CarSpaceMap *build_car_space_map(const Lot lot) {
+  CarSpaceMap *map = malloc(sizeof(CarSpaceMap));
+  map->space_of = NULL;
+  map->capacity = 0;
+  for (int i = 0; i < lot.space_count; i++) {
+    int car_index = lot.spaces[i].occupied;
+    if (car_index >= 0) {
+      ensure_car_capacity(map, car_index);
+      map->space_of[car_index] = i;
     }
-    if (!found) {
-      levels[level_count++] = level;
+  }
+  return map;
+}
+
+void free_car_space_map(CarSpaceMap *map) {
+  if (!map) return;
+  free(map->space_of);
+  free(map);
+}
+
+// === Space columns ===
+
+// copy the scanned fields of every space into their own arrays
+SpaceColumns *build_space_columns(const Lot lot) {
+  SpaceColumns *columns = malloc(sizeof(SpaceColumns));
+  int n = lot.space_count + 1; // never malloc 0 bytes
+  columns->type = malloc(sizeof(int) * n);
+  columns->level = malloc(sizeof(int) * n);
+  columns->x = malloc(sizeof(double) * n);
+  columns->y = malloc(sizeof(double) * n);
+  columns->occupied = malloc(sizeof(int) * n);
+  columns->count = lot.space_count;
+  for (int i = 0; i < lot.space_count; i++) {
+    columns->type[i] = lot.spaces[i].type;
+    columns->level[i] = lot.spaces[i].location.level;
+    columns->x[i] = lot.spaces[i].location.x;
+    columns->y[i] = lot.spaces[i].location.y;
+    columns->occupied[i] = lot.spaces[i].occupied;
+  }
+  return columns;
+}
+
+void free_space_columns(SpaceColumns *columns) {
+  if (!columns) return;
+  free(columns->type);
+  free(columns->level);
+  free(columns->x);
+  free(columns->y);
+  free(columns->occupied);
+  free(columns);
+}
+
+// === Occupancy ===
+// occupancy should only change through these two so the queues and the car map stay in sync
+
+// mark a space as occupied by a car and take it out of its queue
+// spaces that are not on top of their queue are dropped lazily once they get there
+void occupy_space(const Lot lot, Space *space, int car_index) {
+  int space_index = (int)(space - lot.spaces);
+  space->occupied = car_index;
+  if (lot.columns) lot.columns->occupied[space_index] = car_index;
+  if (lot.parked && car_index >= 0) {
+    ensure_car_capacity(lot.parked, car_index);
+    lot.parked->space_of[car_index] = space_index;
+  }
+  if (!lot.free_spaces) return;
+
+  if (lot.free_spaces->size[space->type] > 0 && lot.free_spaces->heap[space->type][0] == space_index) {
+    queue_pop(lot, space->type);
+  }
+}
+
+// mark a space as free again and put it back in its queue
+void vacate_space(const Lot lot, Space *space) {
+  int space_index = (int)(space - lot.spaces);
+  int car_index = space->occupied;
+  space->occupied = -1;
+  if (lot.columns) lot.columns->occupied[space_index] = -1;
+  if (lot.parked && car_index >= 0 && car_index < lot.parked->capacity) {
+    lot.parked->space_of[car_index] = -1;
+  }
+  if (!lot.free_spaces) return;
+
+  // a space that still has a (stale) entry is simply valid again
+  if (!lot.free_spaces->queued[space_index] && lot.routes->space_routes[space_index].cost >= 0) {
+    queue_push(lot, space->type, space_index);
+  }
+}
+
+// pop entries off the top of a queue until the top space is actually free
+static Space *queue_peek(const Lot lot, SpaceType type) {
+  SpaceQueues *queues = lot.free_spaces;
+  while (queues->size[type] > 0) {
+    Space *top = &lot.spaces[queues->heap[type][0]];
+    if (top->occupied == -1 && top->type == type) {
+      return top;
     }
+    queue_pop(lot, type);
   }
-  free(levels);
-  return level_count;
+  return NULL;
 }
 
 // find the best available space of a given type; best means closest to the
 // entrance
 Space *best_space(const Lot lot, SpaceType type) {
+  // loaded lots keep their free spaces in queues, so the best one is always on top
+  if (lot.free_spaces && lot.routes) {
+    return queue_peek(lot, type);
+  }
+
+  // lots built by hand get a temporary route index and a scan
+  LotRouteIndex *routes = lot.routes ? lot.routes : build_route_index(lot);
   Space *best = NULL;
   double best_distance = -1.0;
 
@@ -160,18 +328,11 @@ Space *best_space(const Lot lot, SpaceType type) {
       continue;
     }
 
-    // calculate distance from entrance
-    int count = 0;
-    Path *superpath = superpath_to_space(lot, lot.spaces[i], &count);
-    if (count == -1) {
+    // distance from the entrance, ramps included
+    double distance = routes->space_routes[i].cost;
+    if (distance < 0) {
       continue; // no valid path to this space
     }
-    double distance = superpath_length(superpath, count);
-    free(superpath);
-
-    // add ramp length * level difference (if 0 nothing is added)
-    int level_diff = abs(lot.spaces[i].location.level - lot.entrance.level);
-    distance += level_diff * lot.ramp_length;
 
     // check if this is the best (shortest) so far
     if (best_distance < 0 || distance < best_distance) {
@@ -179,12 +340,22 @@ Space *best_space(const Lot lot, SpaceType type) {
       best = &lot.spaces[i];
     }
   }
+
+  if (routes != lot.routes) free_route_index(routes);
   return best;
 }
 
 // count the number of occupied spaces in the lot
 int count_occupied_spaces(const Lot lot) {
   int count = 0;
+  if (lot.columns) {
+    // branch free over a plain int array, so this compiles to a vectorised loop
+    const int *occupied = lot.columns->occupied;
+    for (int i = 0; i < lot.columns->count; i++) {
+      count += occupied[i] != -1;
+    }
+    return count;
+  }
   for (int i = 0; i < lot.space_count; i++) {
     if (lot.spaces[i].occupied != -1) {
       count++;
@@ -212,7 +383,7 @@ CheckInResult handle_checkin(const Lot lot, const Car car, const int car_index,
   int space_index = get_occupied_space_from_car(lot, car_index);
   if (space_index >= 0 && space_index < lot.space_count) {
     // car is already checked in, so check it out
-    lot.spaces[space_index].occupied = -1;
+    vacate_space(lot, &lot.spaces[space_index]);
     printf("Car with plate %s checked out successfully.\n", car.plate);
     printf("Thank you for using our parking lot! Goodbye!\n");
     return CheckOutSuccess; // this cannot fail (famous last words)
@@ -234,7 +405,7 @@ CheckInResult handle_checkin(const Lot lot, const Car car, const int car_index,
   if (foundSpace != NULL) {
     // successfully found a space of the ideal type
     // very simple, just occupy it
-    foundSpace->occupied = car_index;
+    occupy_space(lot, foundSpace, car_index);
     printf("Car with plate %s checked in successfully to space %s.\n",
             car.plate, foundSpace->name);
     if (out_space) *out_space = foundSpace;
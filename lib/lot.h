@@ -1,6 +1,15 @@
 #pragma once
 #include <data.h>
 
+// one min-heap of free spaces per SpaceType, ordered by route cost from the entrance
+// spaces that become occupied behind the queues' back are dropped lazily when they reach the top
+struct SpaceQueues {
+  int *heap[4];  // space indices, one heap per SpaceType
+  int size[4];
+  char *queued;  // 1 if the space has an entry in its heap (which may be stale)
+  int space_count;
+};
+
 Lot create_lot(int level_count, int path_count, int space_count, int up_count, int down_count);
 void free_lot(Lot lot);
 void print_lot(const Lot lot);
@@ -10,6 +19,15 @@ int count_levels(const Lot lot);
 Space* best_space(const Lot lot, SpaceType type);
 int count_occupied_spaces(const Lot lot);
 
+SpaceQueues* build_space_queues(const Lot lot);
+void free_space_queues(SpaceQueues* queues);
+CarSpaceMap* build_car_space_map(const Lot lot);
+void free_car_space_map(CarSpaceMap* map);
+SpaceColumns* build_space_columns(const Lot lot);
+void free_space_columns(SpaceColumns* columns);
+void occupy_space(const Lot lot, Space* space, int car_index);
+void vacate_space(const Lot lot, Space* space);
+
 typedef enum {
     CheckInSuccess,
     CheckOutSuccess,
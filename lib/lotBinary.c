@@ -0,0 +1,232 @@
+#include "lotBinary.h"
+#include "data.h"
+#include "lot.h"
+#include "nav.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char lot_binary_magic[8] = "P1LOTB";
+static const uint32_t lot_binary_version = 2;
+
+// rounds a byte offset up to the next multiple of 8 so every array stays aligned
+static uint64_t align_to_8(uint64_t offset) {
+  return (offset + 7) & ~(uint64_t)7;
+}
+
+// the size and modification time of a file; returns 0 if it cannot be looked at
+static int source_stamp(const char *filename, uint64_t *out_size, int64_t *out_mtime) {
+  struct stat info;
+  if (!filename || stat(filename, &info) != 0) return 0;
+  *out_size = (uint64_t)info.st_size;
+  *out_mtime = (int64_t)info.st_mtime;
+  return 1;
+}
+
+// write the given bytes at an offset, padding the file with zeros up to it
+static int write_at(FILE *fptr, uint64_t offset, const void *data, size_t size) {
+  static const char zeros[8] = {0};
+  long position = ftell(fptr);
+  if (position < 0 || (uint64_t)position > offset || offset - position > sizeof(zeros)) return 0;
+  if (fwrite(zeros, 1, offset - position, fptr) != offset - position) return 0;
+  return size == 0 || fwrite(data, 1, size, fptr) == size;
+}
+
+// write a lot (and the result of validating it) as a compiled lot file
+// source_filename is the .lot it was read from (or NULL), so loading can tell when that has changed since
+// returns 0 on success and 1 if the file could not be written
+int lot_to_binary(const Lot lot, ValidationResult validation, const char *source_filename, const char *filename) {
+  // the name table holds every name back to back; spaces store their name's offset in it
+  uint64_t names_size = 0;
+  for (int i = 0; i < lot.space_count; i++) {
+    names_size += strlen(lot.spaces[i].name) + 1;
+  }
+  char *names = malloc(names_size + 1);
+  Space *spaces = malloc(sizeof(Space) * (lot.space_count + 1));
+  uint64_t name_offset = 0;
+  for (int i = 0; i < lot.space_count; i++) {
+    size_t length = strlen(lot.spaces[i].name) + 1;
+    memcpy(names + name_offset, lot.spaces[i].name, length);
+    spaces[i] = lot.spaces[i];
+    spaces[i].name = (char *)(uintptr_t)name_offset;
+    name_offset += length;
+  }
+
+  LotBinaryHeader header = {0};
+  memcpy(header.magic, lot_binary_magic, sizeof(header.magic));
+  header.version = lot_binary_version;
+  header.space_size = sizeof(Space);
+  header.path_size = sizeof(Path);
+  header.location_size = sizeof(Location);
+  header.route_size = sizeof(SpaceRoute);
+  header.level_count = lot.level_count;
+  header.space_count = lot.space_count;
+  header.path_count = lot.path_count;
+  header.up_count = lot.up_count;
+  header.down_count = lot.down_count;
+  header.validation_result = validation.result;
+  header.validation_error = validation.error;
+  header.has_routes = lot.routes != NULL && lot.routes->space_count == lot.space_count;
+  header.entrance = lot.entrance;
+  header.POI = lot.POI;
+  header.ramp_length = lot.ramp_length;
+  source_stamp(source_filename, &header.source_size, &header.source_mtime);
+
+  // lay out every section one after another
+  header.spaces_offset = align_to_8(sizeof(LotBinaryHeader));
+  header.paths_offset = align_to_8(header.spaces_offset + sizeof(Space) * lot.space_count);
+  header.ups_offset = align_to_8(header.paths_offset + sizeof(Path) * lot.path_count);
+  header.downs_offset = align_to_8(header.ups_offset + sizeof(Location) * lot.up_count);
+  header.names_offset = align_to_8(header.downs_offset + sizeof(Location) * lot.down_count);
+  header.names_size = names_size;
+  header.routes_offset = align_to_8(header.names_offset + names_size);
+  header.file_size = header.routes_offset + (header.has_routes ? sizeof(SpaceRoute) * lot.space_count : 0);
+
+  int ok = 0;
+  FILE *fptr = fopen(filename, "wb");
+  if (fptr != NULL) {
+    ok = write_at(fptr, 0, &header, sizeof(header)) &&
+         write_at(fptr, header.spaces_offset, spaces, sizeof(Space) * lot.space_count) &&
+         write_at(fptr, header.paths_offset, lot.paths, sizeof(Path) * lot.path_count) &&
+         write_at(fptr, header.ups_offset, lot.ups, sizeof(Location) * lot.up_count) &&
+         write_at(fptr, header.downs_offset, lot.downs, sizeof(Location) * lot.down_count) &&
+         write_at(fptr, header.names_offset, names, names_size);
+    if (ok && header.has_routes) {
+      ok = write_at(fptr, header.routes_offset, lot.routes->space_routes, sizeof(SpaceRoute) * lot.space_count);
+    }
+    ok = (fclose(fptr) == 0) && ok;
+  }
+
+  free(names);
+  free(spaces);
+  if (!ok) {
+    printf("ERROR: Failed to write compiled lot %s!\n", filename);
+  }
+  return !ok;
+}
+
+// check that a section lies completely inside the file
+static int section_fits(const LotBinaryHeader *header, uint64_t offset, uint64_t count, uint64_t size) {
+  return offset % 8 == 0 && offset <= header->file_size && count <= (header->file_size - offset) / (size ? size : 1);
+}
+
+// check everything in the header before any of it is trusted
+static int header_valid(const LotBinaryHeader *header, uint64_t file_size) {
+  if (memcmp(header->magic, lot_binary_magic, sizeof(header->magic)) != 0) return 0;
+  if (header->version != lot_binary_version || header->file_size != file_size) return 0;
+  if (header->space_size != sizeof(Space) || header->path_size != sizeof(Path) ||
+      header->location_size != sizeof(Location) || header->route_size != sizeof(SpaceRoute)) {
+    return 0; // compiled by a build with different structs
+  }
+  if (header->space_count < 0 || header->path_count < 0 || header->up_count < 0 || header->down_count < 0) return 0;
+  return section_fits(header, header->spaces_offset, header->space_count, sizeof(Space)) &&
+         section_fits(header, header->paths_offset, header->path_count, sizeof(Path)) &&
+         section_fits(header, header->ups_offset, header->up_count, sizeof(Location)) &&
+         section_fits(header, header->downs_offset, header->down_count, sizeof(Location)) &&
+         section_fits(header, header->names_offset, header->names_size, 1) &&
+         (!header->has_routes || section_fits(header, header->routes_offset, header->space_count, sizeof(SpaceRoute)));
+}
+
+// map a compiled lot file; nothing is parsed, counted or validated again
+// the mapping is copy-on-write, so changing the lot (e.g. occupancy) never touches the file
+// if source_filename is given and that file is not the one the lot was compiled from (any more),
+// the compiled lot and its validation result are out of date and it is refused;
+// a source that cannot be found is nothing to be out of date with, so then the compiled lot is used
+// returns 0 on success and 1 if the file is missing, out of date or not a valid compiled lot
+int lot_from_binary(const char *filename, const char *source_filename, Lot *out_lot, ValidationResult *out_validation) {
+  int fd = open(filename, O_RDONLY);
+  if (fd < 0) {
+    return 1;
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(LotBinaryHeader)) {
+    close(fd);
+    return 1;
+  }
+  void *map = mmap(NULL, info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd); // the mapping stays valid after closing
+  if (map == MAP_FAILED) {
+    return 1;
+  }
+
+  char *bytes = map;
+  const LotBinaryHeader *header = map;
+  if (!header_valid(header, info.st_size)) {
+    munmap(map, info.st_size);
+    return 1;
+  }
+  uint64_t source_size;
+  int64_t source_mtime;
+  if (source_stamp(source_filename, &source_size, &source_mtime) &&
+      (source_size != header->source_size || source_mtime != header->source_mtime)) {
+    munmap(map, info.st_size);
+    return 1;
+  }
+
+  Lot lot = create_lot(header->level_count, 0, 0, 0, 0);
+  free(lot.spaces); // the arrays from create_lot are replaced by the mapped ones
+  free(lot.paths);
+  free(lot.ups);
+  free(lot.downs);
+  lot.mapping = map;
+  lot.mapping_size = info.st_size;
+  lot.spaces = (Space *)(bytes + header->spaces_offset);
+  lot.paths = (Path *)(bytes + header->paths_offset);
+  lot.ups = (Location *)(bytes + header->ups_offset);
+  lot.downs = (Location *)(bytes + header->downs_offset);
+  lot.space_count = header->space_count;
+  lot.path_count = header->path_count;
+  lot.up_count = header->up_count;
+  lot.down_count = header->down_count;
+  lot.entrance = header->entrance;
+  lot.POI = header->POI;
+  lot.ramp_length = header->ramp_length;
+
+  // turn the stored name offsets back into pointers into the name table,
+  // and refuse types the text loader would not have read either
+  char *names = bytes + header->names_offset;
+  for (int i = 0; i < lot.space_count; i++) {
+    uintptr_t offset = (uintptr_t)lot.spaces[i].name;
+    if (offset >= header->names_size || memchr(names + offset, '\0', header->names_size - offset) == NULL ||
+        lot.spaces[i].type < Standard || lot.spaces[i].type > EV) {
+      munmap(map, info.st_size);
+      return 1;
+    }
+    lot.spaces[i].name = names + offset;
+    lot.spaces[i].occupied = -1; // a freshly loaded lot is empty
+  }
+
+  // same as the text loader, a level the table can't hold means the file is broken
+  int min_level, max_level;
+  if (level_span_out_of_range(lot, &min_level, &max_level)) {
+    munmap(map, info.st_size);
+    return 1;
+  }
+  lot.levels = build_level_table(lot);
+  lot.geometry = build_space_geometry(lot);
+  lot.clearance_corridors = build_corridor_index(lot, path_clearance);
+  lot.access_corridors = build_corridor_index(lot, path_accessibility);
+
+  // the route tree is cheap to rebuild; the expensive per-space routes come from the file
+  if (header->has_routes) {
+    lot.routes = build_route_tree(lot);
+    lot.routes->space_routes = malloc(sizeof(SpaceRoute) * (lot.space_count + 1));
+    memcpy(lot.routes->space_routes, bytes + header->routes_offset, sizeof(SpaceRoute) * lot.space_count);
+    lot.routes->space_count = lot.space_count;
+  } else {
+    lot.routes = build_route_index(lot);
+  }
+  lot.free_spaces = build_space_queues(lot);
+  lot.parked = build_car_space_map(lot);
+  lot.columns = build_space_columns(lot);
+
+  if (out_validation) {
+    *out_validation = (ValidationResult){ header->validation_result, header->validation_error };
+  }
+  *out_lot = lot;
+  return 0;
+}
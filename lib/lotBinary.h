@@ -0,0 +1,45 @@
+#pragma once
+#include <data.h>
+#include <stdint.h>
+#include <validate.h>
+
+// Header of a compiled lot file (.lotb)
+// The header is followed by the Space, Path, up and down arrays, the name table and
+// (if has_routes) the SpaceRoute of every space, each starting on an 8 byte boundary.
+// Structs are stored exactly as they are in memory, so a file only loads in a build
+// with the same struct sizes (checked through the *_size fields).
+// The size and modification time of the .lot it was compiled from are kept too, so a
+// compiled lot that is older than its source is not used.
+typedef struct {
+  char magic[8]; // "P1LOTB" followed by null bytes
+  uint32_t version;
+  uint32_t space_size;
+  uint32_t path_size;
+  uint32_t location_size;
+  uint32_t route_size;
+  int32_t level_count;
+  int32_t space_count;
+  int32_t path_count;
+  int32_t up_count;
+  int32_t down_count;
+  int32_t validation_result; // the ValidationResult of the lot when it was compiled
+  int32_t validation_error;
+  int32_t has_routes;
+  int32_t reserved;
+  Location entrance;
+  Location POI;
+  double ramp_length;
+  uint64_t spaces_offset;
+  uint64_t paths_offset;
+  uint64_t ups_offset;
+  uint64_t downs_offset;
+  uint64_t names_offset; // every name null terminated, one after another
+  uint64_t names_size;
+  uint64_t routes_offset;
+  uint64_t file_size;
+  uint64_t source_size;  // 0 with source_mtime 0 if it was not compiled from a file
+  int64_t source_mtime;
+} LotBinaryHeader;
+
+int lot_to_binary(const Lot lot, ValidationResult validation, const char *source_filename, const char *filename);
+int lot_from_binary(const char *filename, const char *source_filename, Lot *out_lot, ValidationResult *out_validation);
@@ -1,280 +1,359 @@
 #include "data.h"
 #include "lot.h"
+#include "nav.h"
+#include "validate.h"
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-Space* readSpace(const char *line) {
-  // Reading a space from a line
-  // It consists of name, type, location(x,y,level), rotation
-  char name[11];
-  double x, y, rotation;
-  int level, itype;
+// === Hand-written scanning helpers ===
+// these work directly on the file buffer; c is advanced past whatever was read.
+// end is the end of the current line, nothing past it is ever accepted.
+
+// match a literal like sscanf would: a space matches any amount of whitespace (even none)
+static int match_literal(const char **c, const char *end, const char *literal) {
+  for (; *literal; literal++) {
+    if (*literal == ' ') {
+      while (*c < end && (**c == ' ' || **c == '\t')) (*c)++;
+    } else if (*c < end && **c == *literal) {
+      (*c)++;
+    } else {
+      return 0;
+    }
+  }
+  return 1;
+}
 
-  // Getting info from the line
-  if (!line) return NULL; // dont dereference a null pointer dude
-  int n = sscanf(line, "name=%10s type=%d location(x=%lf y=%lf level=%d) rotation=%lf",
-         name, &itype, &x, &y, &level, &rotation);
+// read a double; strtod gives exactly the same value sscanf's %lf would
+static int scan_double(const char **c, const char *end, double *out) {
+  char *after;
+  *out = strtod(*c, &after);
+  if (after == *c || after > end) return 0;
+  *c = after;
+  return 1;
+}
 
-  // Validating the read
-  if (n != 6) {
-    printf("ERROR: Invalid space line format: %s\n", line);
-    return NULL;
+static int scan_int(const char **c, const char *end, int *out) {
+  char *after;
+  *out = (int)strtol(*c, &after, 10);
+  if (after == *c || after > end) return 0;
+  *c = after;
+  return 1;
+}
+
+// read a word of at most max_length characters, like sscanf's %10s
+static int scan_word(const char **c, const char *end, char *out, int max_length) {
+  while (*c < end && (**c == ' ' || **c == '\t')) (*c)++;
+  int length = 0;
+  while (*c < end && length < max_length && **c != ' ' && **c != '\t') {
+    out[length++] = *(*c)++;
   }
+  out[length] = '\0';
+  return length > 0;
+}
 
-  // Updating the values
-  SpaceType type = (SpaceType)itype;
+// === Line parsers ===
+// they fill in the given struct and return 1, or return 0 if the line is malformed
 
-  // create the space and return pointer to it
-  Space* space = malloc(sizeof(Space));
-  if (!space) return NULL; // malloc failed
-  space->type = type;
+// It consists of name, type, location(x,y,level), rotation
+// the name is copied into name (room for 10 characters and the terminator), space->name is left alone
+static int parse_space(const char *line, const char *end, Space *space, char *name) {
+  double x, y, rotation;
+  int level, itype;
+
+  const char *c = line;
+  if (!match_literal(&c, end, "name=") || !scan_word(&c, end, name, 10) ||
+      !match_literal(&c, end, " type=") || !scan_int(&c, end, &itype) ||
+      !match_literal(&c, end, " location(x=") || !scan_double(&c, end, &x) ||
+      !match_literal(&c, end, " y=") || !scan_double(&c, end, &y) ||
+      !match_literal(&c, end, " level=") || !scan_int(&c, end, &level) ||
+      !match_literal(&c, end, ") rotation=") || !scan_double(&c, end, &rotation)) {
+    return 0;
+  }
+  // the type picks a free space queue, so anything past the last type would be written out of bounds
+  if (itype < Standard || itype > EV) {
+    return 0;
+  }
+
+  space->type = (SpaceType)itype;
   space->location = (Location){x, y, level};
   space->rotation = rotation;
-  space->name = strdup(name);
   space->occupied = -1;
+  return 1;
+}
 
-  if (!space->name) {
-    free(space);
-    return NULL; // strdup can fail
-  }
+// It consists of vector(x,y) and location(x,y,level)
+static int parse_path(const char *line, const char *end, Path *path) {
+  double vx, vy;
+  double location_x, location_y;
+  int level;
 
-  // printf("Created space: Name=%s, Type=%d, Location=(%.2f, %.2f %d),  "
-  //        "Rotation=%.2f\n",
-  //        space.name, space.type, space.location.x, space.location.y,
-  //        space.location.level, space.rotation);
+  const char *c = line;
+  if (!match_literal(&c, end, "vec(x=") || !scan_double(&c, end, &vx) ||
+      !match_literal(&c, end, " y=") || !scan_double(&c, end, &vy) ||
+      !match_literal(&c, end, ") location(x=") || !scan_double(&c, end, &location_x) ||
+      !match_literal(&c, end, " y=") || !scan_double(&c, end, &location_y) ||
+      !match_literal(&c, end, " level=") || !scan_int(&c, end, &level)) {
+    return 0;
+  }
 
-  return space;
-};
+  path->vector = (Vector){vx, vy};
+  path->start_point = (Location){location_x, location_y, level};
+  return 1;
+}
 
-Path* readPath(const char *line) {
-  // Reading a path from a line
-  // It consists of vector(x,y) and location(x,y,level)
-  double vx, vy;
-  double location_x, location_y;
+static int parse_location(const char *line, const char *end, Location *loc) {
+  double x, y;
   int level;
 
-  // Getting info from the line
-  if (!line) return NULL; // dont dereference a null pointer dude
-  int n = sscanf(line, "vec(x=%lf y=%lf) location(x=%lf y=%lf level=%d)", &vx, &vy,
-         &location_x, &location_y, &level);
+  const char *c = line;
+  if (!match_literal(&c, end, " x=") || !scan_double(&c, end, &x) ||
+      !match_literal(&c, end, " y=") || !scan_double(&c, end, &y) ||
+      !match_literal(&c, end, " level=") || !scan_int(&c, end, &level)) {
+    return 0;
+  }
 
-  // Validating the read
-  if (n != 5) {
-    printf("ERROR: Invalid path line format: %s\n", line);
+  *loc = (Location){x, y, level};
+  return 1;
+}
+
+Space* readSpace(const char *line) {
+  // Reading a space from a line into a new heap object
+  if (!line) return NULL; // dont dereference a null pointer dude
+  Space space;
+  char name[11];
+  if (!parse_space(line, line + strlen(line), &space, name)) {
+    printf("ERROR: Invalid space line format: %s\n", line);
     return NULL;
   }
+  space.name = strdup(name);
+  if (!space.name) return NULL; // strdup can fail
 
-  // create a path
-  Path* path = malloc(sizeof(Path));
-  if (!path) return NULL; // malloc failed
+  // create the space and return pointer to it
+  Space* result = malloc(sizeof(Space));
+  if (!result) {
+    free(space.name);
+    return NULL; // malloc failed
+  }
+  *result = space;
+  return result;
+};
 
-  // Updating the values
-  path->vector = (Vector){vx, vy};
-  path->start_point = (Location){location_x, location_y, level};
+Path* readPath(const char *line) {
+  // Reading a path from a line into a new heap object
+  if (!line) return NULL; // dont dereference a null pointer dude
+  Path path;
+  if (!parse_path(line, line + strlen(line), &path)) {
+    printf("ERROR: Invalid path line format: %s\n", line);
+    return NULL;
+  }
 
-  // printf("Created path: Vector=(%.2f, %.2f), location=(%.2f, %.2f, "
-  //        "Level %d)\n",
-  //        path.vector.x, path.vector.y, path.start_point.x,
-  //        path.start_point.y, path.start_point.level);
-  return path;
+  Path* result = malloc(sizeof(Path));
+  if (!result) return NULL; // malloc failed
+  *result = path;
+  return result;
 };
 
 Location* readLocation(const char *line) {
-  // Reading a location from a line
-  double x, y;
-  int level;
-
-  // Getting info from the line
+  // Reading a location from a line into a new heap object
   if (!line) return NULL; // dont dereference a null pointer dude
-  int n = sscanf(line, "x=%lf y=%lf level=%d", &x, &y, &level);
-
-  // Validating the read
-  if (n != 3) {
+  Location loc;
+  if (!parse_location(line, line + strlen(line), &loc)) {
     printf("ERROR: Invalid location line format: %s\n", line);
     return NULL;
   }
 
-  // create location
-  Location* loc = malloc(sizeof(Location));
-  if (!loc) return NULL; // malloc failed
+  Location* result = malloc(sizeof(Location));
+  if (!result) return NULL; // malloc failed
+  *result = loc;
+  return result;
+};
 
-  // Updating the values
-  *loc = (Location){x, y, level};
+// make sure array has room for one more element, doubling its capacity when full
+static void *grow_if_full(void *array, int count, int *capacity, size_t element_size) {
+  if (count < *capacity) return array;
+  *capacity *= 2;
+  void *grown = realloc(array, *capacity * element_size);
+  if (!grown) {
+    printf("ERROR: Memory reallocation failed!\n");
+    exit(1);
+  }
+  return grown;
+}
 
-  // printf("Created location: (%.2f, %.2f, Level %d)\n", loc.x, loc.y,
-  // loc.level);
-  return loc;
-};
+// read a whole file into a null terminated buffer
+static char *read_whole_file(const char *filename, size_t *out_size) {
+  FILE *fptr = fopen(filename, "rb");
+  if (fptr == NULL) {
+    return NULL;
+  }
+  fseek(fptr, 0, SEEK_END);
+  long size = ftell(fptr);
+  fseek(fptr, 0, SEEK_SET);
+  char *contents = malloc(size + 1);
+  if (!contents) {
+    fclose(fptr);
+    return NULL;
+  }
+  *out_size = fread(contents, 1, size, fptr);
+  contents[*out_size] = '\0';
+  // Closing file again
+  fclose(fptr);
+  return contents;
+}
 
 // taking a filename, read the lot data from the file and return a Lot struct
 Lot lot_from_file(char *filename) {
   // initialize a lot struct with 1 of everything
   Lot lot = create_lot(1, 1, 1, 1, 1);
   lot.ramp_length = 40.0; // default ramp length
-  // Opening the file for reading
-  FILE *fptr = fopen(filename, "r");
 
-  // Buffer to hold each line and counting variables
-  char buffer[420];
-  int stage = 0;
-  int SpaceCount = 0;
-  int PathCount = 0;
-  int UpCount = 0;
-  int DownCount = 0;
+  // Reading the whole file at once; every line is parsed straight out of this buffer
+  size_t size = 0;
+  char *contents = read_whole_file(filename, &size);
 
   // Checking if file opened successfully
-  if (fptr == NULL) {
+  if (contents == NULL) {
     printf("ERROR: Cant open file!\n");
     exit(1);
   }
 
-  // Read each line from the file
-  while (fgets(buffer, sizeof(buffer), fptr)) {
-    if (strlen(buffer) <= 1) {
+  // Counting variables; the arrays double in size whenever they fill up
+  int stage = 0;
+  int SpaceCount = 0, SpaceCapacity = 1;
+  int PathCount = 0, PathCapacity = 1;
+  int UpCount = 0, UpCapacity = 1;
+  int DownCount = 0, DownCapacity = 1;
+  // every space name goes into one arena instead of its own strdup
+  size_t NamesSize = 0, NamesCapacity = 64;
+  char *names = malloc(NamesCapacity);
+  if (!names) {
+    printf("ERROR: Memory allocation failed!\n");
+    exit(1);
+  }
+
+  // Go through each line of the file
+  const char *file_end = contents + size;
+  for (const char *line = contents; line < file_end;) {
+    const char *newline = memchr(line, '\n', file_end - line);
+    const char *end = newline ? newline : file_end;
+    const char *next = newline ? newline + 1 : file_end;
+    if (end > line && end[-1] == '\r') end--; // files saved on windows
+
+    if (end == line) {
       // This is an empty line, skip it
+      line = next;
       continue;
     }
-    if (buffer[0] == '#') {
+    if (line[0] == '#') {
       // This is a comment line, skip it
+      line = next;
       continue;
     }
 
-    if (buffer[0] == '[') {
+    int length = (int)(end - line);
+    if (line[0] == '[') {
       // This is a header line
       // Determine which section we are in
-      if (strcmp(buffer, "[Spaces]\n") == 0) {
-        stage = 1;
-      } else if (strcmp(buffer, "[Paths]\n") == 0) {
-        stage = 2;
-      } else if (strcmp(buffer, "[Ups]\n") == 0) {
-        stage = 3;
-      } else if (strcmp(buffer, "[Downs]\n") == 0) {
-        stage = 4;
-      } else if (strcmp(buffer, "[POI]\n") == 0) {
-        stage = 5;
-      } else if (strcmp(buffer, "[Entrance]\n") == 0) {
-        stage = 6;
-      } else if (strcmp(buffer, "[Ramp Length]\n") == 0) {
-        stage = 7;
-      } else {
+      static const char *headers[] = {
+        "[Spaces]", "[Paths]", "[Ups]", "[Downs]", "[POI]", "[Entrance]", "[Ramp Length]"
+      };
+      stage = 0;
+      for (int h = 0; h < 7; h++) {
+        if ((int)strlen(headers[h]) == length && strncmp(line, headers[h], length) == 0) {
+          stage = h + 1;
+        }
+      }
+      if (stage == 0) {
         // Unknown header, "handle" error
-        printf("Unknown header: |%s|\n", buffer);
+        printf("Unknown header: |%.*s|\n", length, line);
         exit(1);
       }
+      line = next;
       continue;
     }
 
     // This is a data line
     if (stage == 1) {
-      // Process space data
-      Space *space = readSpace(buffer);
-      if (!space) {
-        printf("ERROR: Failed to read space from line: %s\n", buffer);
+      // Process space data straight into the lot
+      lot.spaces = grow_if_full(lot.spaces, SpaceCount, &SpaceCapacity, sizeof(Space));
+      char name[11];
+      if (!parse_space(line, end, &lot.spaces[SpaceCount], name)) {
+        printf("ERROR: Failed to read space from line: %.*s\n", length, line);
         exit(1);
       }
-      // Copy the struct, but fix the name pointer
-      lot.spaces[SpaceCount] = *space; // copies everything including pointer
-      lot.spaces[SpaceCount].name = space->name; // transfer ownership
-      space->name = NULL; // prevent double free
-
-      free(space);
-      SpaceCount++;
-      if (SpaceCount == lot.space_count) {
-        // Resize the spaces array if needed
-        lot.space_count += 25;
-        Space* spaceres = realloc(lot.spaces, lot.space_count * sizeof(Space));
-        if (!spaceres) {
+      size_t name_size = strlen(name) + 1;
+      while (NamesSize + name_size > NamesCapacity) {
+        NamesCapacity *= 2;
+        names = realloc(names, NamesCapacity);
+        if (!names) {
           printf("ERROR: Memory reallocation failed!\n");
           exit(1);
         }
-        lot.spaces = spaceres;
       }
+      memcpy(names + NamesSize, name, name_size);
+      // the arena can still move, so only the offset is kept until the whole file is read
+      lot.spaces[SpaceCount].name = (char *)(uintptr_t)NamesSize;
+      NamesSize += name_size;
+      SpaceCount++;
     } else if (stage == 2) {
       // Process path data
-      Path *path = readPath(buffer);
-      if (!path) {
-        printf("ERROR: Failed to read path from line: %s\n", buffer);
+      lot.paths = grow_if_full(lot.paths, PathCount, &PathCapacity, sizeof(Path));
+      if (!parse_path(line, end, &lot.paths[PathCount])) {
+        printf("ERROR: Failed to read path from line: %.*s\n", length, line);
         exit(1);
       }
-      lot.paths[PathCount++] = *path;
-      free(path);
-      if (PathCount == lot.path_count) {
-        // Resize the paths array if needed
-        lot.path_count += 25;
-        Path* pathres = realloc(lot.paths, lot.path_count * sizeof(Path));
-        if (!pathres) {
-          printf("ERROR: Memory reallocation failed!\n");
-          exit(1);
-        }
-        lot.paths = pathres;
-      }
+      PathCount++;
     } else if (stage > 2 && stage < 7) {
       // It has to be stage 3,4,5, or 6 since they are all just a location
       // Is still different stages for making it easier to read
       // Process location data
-      Location *location = readLocation(buffer);
-      if (!location) {
-        printf("ERROR: Failed to read location from line: %s\n", buffer);
+      Location location;
+      if (!parse_location(line, end, &location)) {
+        printf("ERROR: Failed to read location from line: %.*s\n", length, line);
         exit(1);
       }
       if (stage == 3) {
-        lot.ups[UpCount++] = *location;
-        if (UpCount == lot.up_count) {
-          // Resize the ups array if needed
-          lot.up_count += 10;
-          Location* upres = realloc(lot.ups, lot.up_count * sizeof(Location));
-          if (!upres) {
-            printf("ERROR: Memory reallocation failed!\n");
-            exit(1);
-          }
-          lot.ups = upres;
-        }
+        lot.ups = grow_if_full(lot.ups, UpCount, &UpCapacity, sizeof(Location));
+        lot.ups[UpCount++] = location;
       } else if (stage == 4) {
-        lot.downs[DownCount++] = *location;
-        if (DownCount == lot.down_count) {
-          // Resize the downs array if needed
-          lot.down_count += 10;
-          Location* downres = realloc(lot.downs, lot.down_count * sizeof(Location));
-          if (!downres) {
-            printf("ERROR: Memory reallocation failed!\n");
-            exit(1);
-          }
-          lot.downs = downres;
-        }
+        lot.downs = grow_if_full(lot.downs, DownCount, &DownCapacity, sizeof(Location));
+        lot.downs[DownCount++] = location;
       } else if (stage == 5) {
         // POI
-        lot.POI = *location;
+        lot.POI = location;
       } else if (stage == 6) {
         // Entrance
-        lot.entrance = *location;
+        lot.entrance = location;
       }
-      free(location);
     } else if (stage == 7) {
-      double length = 0.0;
-      int n = sscanf(buffer, "%lf", &length);
-      if (n != 1) {
-        printf("ERROR: Invalid ramp length line format: %s\n", buffer);
+      double length_value = 0.0;
+      const char *c = line;
+      if (!scan_double(&c, end, &length_value)) {
+        printf("ERROR: Invalid ramp length line format: %.*s\n", length, line);
         exit(1);
       }
-      lot.ramp_length = length;
+      lot.ramp_length = length_value;
     } else {
       // Unknown stage, handle error
       printf("Unknown stage: %d\n", stage);
       exit(1);
     }
+    line = next;
   }
+  free(contents);
 
   // Updating the counts in the lot
   lot.space_count = SpaceCount;
   lot.path_count = PathCount;
   lot.up_count = UpCount;
   lot.down_count = DownCount;
-  // Resizing the arrays to fit the actual counts
-  Space* spaceres = realloc(lot.spaces, lot.space_count * sizeof(Space));
-  Path* pathres = realloc(lot.paths, lot.path_count * sizeof(Path));
-  Location* upres = realloc(lot.ups, lot.up_count * sizeof(Location));
-  Location* downres = realloc(lot.downs, lot.down_count * sizeof(Location));
+  // Resizing the arrays to fit the actual counts (but never to 0, since realloc would free them)
+  Space* spaceres = realloc(lot.spaces, (lot.space_count + 1) * sizeof(Space));
+  Path* pathres = realloc(lot.paths, (lot.path_count + 1) * sizeof(Path));
+  Location* upres = realloc(lot.ups, (lot.up_count + 1) * sizeof(Location));
+  Location* downres = realloc(lot.downs, (lot.down_count + 1) * sizeof(Location));
 
   if (!spaceres || !pathres || !upres || !downres) {
     printf("ERROR: Memory reallocation failed!\n");
@@ -286,11 +365,40 @@ Lot lot_from_file(char *filename) {
   lot.ups = upres;
   lot.downs = downres;
 
-  // we call this ridiculous helper function to count the unique levels in the
-  // lot
+  // shrink the name arena and point every space at its name
+  char *namesres = realloc(names, NamesSize + 1);
+  if (!namesres) {
+    printf("ERROR: Memory reallocation failed!\n");
+    exit(1);
+  }
+  lot.names = namesres;
+  for (int i = 0; i < lot.space_count; i++) {
+    lot.spaces[i].name = lot.names + (uintptr_t)lot.spaces[i].name;
+  }
+
+  // the level table is dense, so a typo'd level would make it huge
+  int min_level, max_level;
+  if (level_span_out_of_range(lot, &min_level, &max_level)) {
+    int item_count = lot.space_count + lot.path_count + lot.up_count + lot.down_count;
+    printf("ERROR: Levels %d to %d are too far apart, a lot with %d things on it can span at most %d levels!\n",
+           min_level, max_level, item_count, item_count);
+    exit(1);
+  }
+
+  // one pass over the lot finds its levels and what is on each of them
+  lot.levels = build_level_table(lot);
   lot.level_count = count_levels(lot);
 
-  // Closing file again
-  fclose(fptr);
+  // the footprint of every space never changes either, and routing and validation both need it
+  lot.geometry = build_space_geometry(lot);
+  lot.clearance_corridors = build_corridor_index(lot, path_clearance);
+  lot.access_corridors = build_corridor_index(lot, path_accessibility);
+
+  // routing from the entrance never changes, so it is computed once here
+  lot.routes = build_route_index(lot);
+  lot.free_spaces = build_space_queues(lot);
+  lot.parked = build_car_space_map(lot);
+  lot.columns = build_space_columns(lot);
+
   return lot;
 }
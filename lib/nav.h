@@ -1,5 +1,26 @@
 #pragma once
 #include <data.h>
+#include <graph.h>
 
+// how a car gets from the path network into a space
+typedef struct {
+  int node;      // graph node at the start of the subpath, -1 if the space is unreachable
+  Path subpath;  // the part of the path driven before turning off
+  Path turnpath; // the turn from the path into the space
+  double cost;   // total distance from the entrance including ramps, -1 if unreachable
+} SpaceRoute;
+
+// shortest routes from the entrance, built once per lot load
+struct LotRouteIndex {
+  PathGraph graph;
+  double *dist;     // shortest distance from the entrance to every graph node
+  int *pred_edge;   // last edge on the shortest route to every graph node
+  SpaceRoute *space_routes; // one per space, in the same order as lot.spaces
+  int space_count;
+};
+
+LotRouteIndex* build_route_tree(const Lot lot);
+LotRouteIndex* build_route_index(const Lot lot);
+void free_route_index(LotRouteIndex* routes);
 Path* superpath_to_space(const Lot lot, const Space space, int* out_count);
 double superpath_length(const Path* superpath, int count);
@@ -0,0 +1,263 @@
+#include "spatial.h"
+#include "data.h"
+#include <math.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+// separating_axis projects onto its axes in float, so two rectangles that are a hair apart
+// can still count as overlapping there. every box gets this much slack (relative to how far
+// it is from the origin) so the broad phase never throws away a pair SAT would have reported.
+static const double relative_slack = 1e-6;
+
+// queries count locally and add their totals here once, so the counters stay cheap (and safe across threads)
+static atomic_llong stats_hits;
+static atomic_llong stats_misses;
+
+static void add_aabb_stats(long long hits, long long misses) {
+  atomic_fetch_add_explicit(&stats_hits, hits, memory_order_relaxed);
+  atomic_fetch_add_explicit(&stats_misses, misses, memory_order_relaxed);
+}
+
+AabbStats aabb_stats(void) {
+  return (AabbStats){
+    atomic_load_explicit(&stats_hits, memory_order_relaxed),
+    atomic_load_explicit(&stats_misses, memory_order_relaxed)
+  };
+}
+
+void reset_aabb_stats(void) {
+  atomic_store_explicit(&stats_hits, 0, memory_order_relaxed);
+  atomic_store_explicit(&stats_misses, 0, memory_order_relaxed);
+}
+
+// a bounding box grown by the slack above
+Aabb aabb_with_slack(Vector min, Vector max) {
+  double extent = fmax(fmax(fabs(min.x), fabs(min.y)), fmax(fabs(max.x), fabs(max.y)));
+  double slack = relative_slack * (1.0 + extent);
+  return (Aabb){ { min.x - slack, min.y - slack }, { max.x + slack, max.y + slack } };
+}
+
+// touching boxes count as overlapping, just like touching projections do in separating_axis
+int aabbs_overlap(Aabb a, Aabb b) {
+  return !(a.max.x < b.min.x || b.max.x < a.min.x || a.max.y < b.min.y || b.max.y < a.min.y);
+}
+
+static int clamp_cell(int cell, int count) {
+  if (cell < 0) return 0;
+  if (cell >= count) return count - 1;
+  return cell;
+}
+
+static int column_of(const AabbGrid *grid, double x) {
+  return clamp_cell((int)floor((x - grid->origin.x) / grid->cell_size), grid->columns);
+}
+
+static int row_of(const AabbGrid *grid, double y) {
+  return clamp_cell((int)floor((y - grid->origin.y) / grid->cell_size), grid->rows);
+}
+
+// build a grid over the boxes
+// cells are as large as the largest box, so a box touches at most 2x2 cells
+AabbGrid build_aabb_grid(const Aabb *boxes, int count) {
+  AabbGrid grid = {0};
+  grid.cell_size = 0.0;
+  Aabb bounds = count > 0 ? boxes[0] : (Aabb){ {0, 0}, {0, 0} };
+  for (int i = 0; i < count; i++) {
+    grid.cell_size = fmax(grid.cell_size, fmax(boxes[i].max.x - boxes[i].min.x, boxes[i].max.y - boxes[i].min.y));
+    bounds.min.x = fmin(bounds.min.x, boxes[i].min.x);
+    bounds.min.y = fmin(bounds.min.y, boxes[i].min.y);
+    bounds.max.x = fmax(bounds.max.x, boxes[i].max.x);
+    bounds.max.y = fmax(bounds.max.y, boxes[i].max.y);
+  }
+  if (grid.cell_size <= 0.0) grid.cell_size = 1.0;
+
+  // spread out lots would need a huge number of empty cells, so cells grow until
+  // there are about as many as boxes
+  double width = bounds.max.x - bounds.min.x;
+  double height = bounds.max.y - bounds.min.y;
+  while ((width / grid.cell_size + 1) * (height / grid.cell_size + 1) > 4.0 * count + 16) {
+    grid.cell_size *= 2;
+  }
+  grid.origin = bounds.min;
+  grid.columns = (int)(width / grid.cell_size) + 1;
+  grid.rows = (int)(height / grid.cell_size) + 1;
+
+  // count the boxes per cell, then hand every cell its slice of items (like the endpoint index)
+  int cell_count = grid.columns * grid.rows;
+  grid.cell_start = calloc(cell_count + 1, sizeof(int));
+  for (int i = 0; i < count; i++) {
+    for (int r = row_of(&grid, boxes[i].min.y); r <= row_of(&grid, boxes[i].max.y); r++) {
+      for (int c = column_of(&grid, boxes[i].min.x); c <= column_of(&grid, boxes[i].max.x); c++) {
+        grid.cell_start[r * grid.columns + c + 1]++;
+      }
+    }
+  }
+  for (int c = 0; c < cell_count; c++) {
+    grid.cell_start[c + 1] += grid.cell_start[c];
+  }
+  grid.items = malloc(sizeof(int) * (grid.cell_start[cell_count] + 1));
+  int *fill = malloc(sizeof(int) * cell_count);
+  for (int c = 0; c < cell_count; c++) fill[c] = grid.cell_start[c];
+  for (int i = 0; i < count; i++) {
+    for (int r = row_of(&grid, boxes[i].min.y); r <= row_of(&grid, boxes[i].max.y); r++) {
+      for (int c = column_of(&grid, boxes[i].min.x); c <= column_of(&grid, boxes[i].max.x); c++) {
+        grid.items[fill[r * grid.columns + c]++] = i;
+      }
+    }
+  }
+  free(fill);
+  return grid;
+}
+
+void free_aabb_grid(AabbGrid grid) {
+  free(grid.cell_start);
+  free(grid.items);
+}
+
+// find every pair of overlapping boxes in the grid, each pair exactly once
+// the pairs are handed to visit in batches: box a together with all the boxes it pairs up with in one cell
+// stops as soon as visit returns something other than 0 and returns that, else returns 0
+int aabb_grid_pairs(const AabbGrid *grid, const Aabb *boxes, int (*visit)(int a, const int *others, int count, void *context), void *context) {
+  int cell_count = grid->columns * grid->rows;
+  int largest = 0;
+  for (int cell = 0; cell < cell_count; cell++) {
+    int size = grid->cell_start[cell + 1] - grid->cell_start[cell];
+    if (size > largest) largest = size;
+  }
+  int *others = malloc(sizeof(int) * (largest + 1));
+
+  int result = 0;
+  long long hits = 0, misses = 0;
+  for (int cell = 0; cell < cell_count && !result; cell++) {
+    for (int i = grid->cell_start[cell]; i < grid->cell_start[cell + 1] && !result; i++) {
+      int count = 0;
+      for (int j = i + 1; j < grid->cell_start[cell + 1]; j++) {
+        Aabb a = boxes[grid->items[i]];
+        Aabb b = boxes[grid->items[j]];
+
+        // two boxes can share several cells; only the lower left one of those gets to look at them,
+        // so every pair is compared (and counted) once whether their boxes overlap or not
+        int column = column_of(grid, fmax(a.min.x, b.min.x));
+        int row = row_of(grid, fmax(a.min.y, b.min.y));
+        if (row * grid->columns + column != cell) continue;
+
+        if (!aabbs_overlap(a, b)) {
+          misses++;
+          continue;
+        }
+        hits++;
+        others[count++] = grid->items[j];
+      }
+      if (count > 0) result = visit(grid->items[i], others, count, context);
+    }
+  }
+  free(others);
+  add_aabb_stats(hits, misses);
+  return result;
+}
+
+// === Bounding volume hierarchy ===
+
+// leaves hold at most this many boxes
+static const int leaf_size = 4;
+
+static double box_centre(const Aabb *box, int axis) {
+  return axis == 0 ? box->min.x + box->max.x : box->min.y + box->max.y; // times two, but only the order matters
+}
+
+// rearrange items so the k-th smallest centre along the axis ends up at position k
+// with everything before it no larger and everything after it no smaller (quickselect)
+static void select_by_centre(int *items, int count, const Aabb *boxes, int axis, int k) {
+  int low = 0, high = count - 1;
+  while (low < high) {
+    double pivot = box_centre(&boxes[items[(low + high) / 2]], axis);
+    int i = low, j = high;
+    while (i <= j) {
+      while (box_centre(&boxes[items[i]], axis) < pivot) i++;
+      while (box_centre(&boxes[items[j]], axis) > pivot) j--;
+      if (i <= j) {
+        int swap = items[i];
+        items[i++] = items[j];
+        items[j--] = swap;
+      }
+    }
+    if (k <= j) high = j;
+    else if (k >= i) low = i;
+    else return;
+  }
+}
+
+static int build_tree_node(AabbTree *tree, const Aabb *boxes, int first, int count) {
+  int node = tree->node_count++;
+  Aabb bounds = boxes[tree->items[first]];
+  for (int i = first + 1; i < first + count; i++) {
+    const Aabb *box = &boxes[tree->items[i]];
+    bounds.min.x = fmin(bounds.min.x, box->min.x);
+    bounds.min.y = fmin(bounds.min.y, box->min.y);
+    bounds.max.x = fmax(bounds.max.x, box->max.x);
+    bounds.max.y = fmax(bounds.max.y, box->max.y);
+  }
+  tree->nodes[node] = (AabbTreeNode){ .box = bounds, .left = -1, .right = -1, .first = first, .count = count };
+  if (count <= leaf_size) return node;
+
+  // split the boxes in half along the longer side of the node
+  int axis = (bounds.max.x - bounds.min.x) >= (bounds.max.y - bounds.min.y) ? 0 : 1;
+  int half = count / 2;
+  select_by_centre(tree->items + first, count, boxes, axis, half);
+  int left = build_tree_node(tree, boxes, first, half);
+  int right = build_tree_node(tree, boxes, first + half, count - half);
+  tree->nodes[node].left = left;
+  tree->nodes[node].right = right;
+  return node;
+}
+
+// build a tree over the given boxes; items are indices into boxes, so a tree can cover any subset
+AabbTree build_aabb_tree(const Aabb *boxes, const int *items, int count) {
+  AabbTree tree = {0};
+  tree.item_count = count;
+  tree.items = malloc(sizeof(int) * (count + 1));
+  for (int i = 0; i < count; i++) tree.items[i] = items[i];
+  tree.nodes = malloc(sizeof(AabbTreeNode) * (2 * count + 1)); // a binary tree with count leaves at most
+  if (count > 0) build_tree_node(&tree, boxes, 0, count);
+  return tree;
+}
+
+void free_aabb_tree(AabbTree tree) {
+  free(tree.nodes);
+  free(tree.items);
+}
+
+// call visit on every item whose box overlaps the given box, in no particular order
+// stops as soon as visit returns something other than 0 and returns that, else returns 0
+int aabb_tree_query(const AabbTree *tree, const Aabb *boxes, Aabb box, int (*visit)(int item, void *context), void *context) {
+  if (tree->node_count == 0) return 0;
+  int stack[64]; // the tree is balanced, so this is far deeper than it will ever get
+  int top = 0;
+  stack[top++] = 0;
+  int result = 0;
+  // an item is a miss when its own box or any node above it is thrown out,
+  // and a query that stops early only counts the items it got to
+  long long hits = 0, misses = 0;
+  while (top > 0 && !result) {
+    const AabbTreeNode *node = &tree->nodes[stack[--top]];
+    if (!aabbs_overlap(node->box, box)) {
+      misses += node->count;
+      continue;
+    }
+    if (node->left == -1) {
+      for (int i = node->first; i < node->first + node->count && !result; i++) {
+        if (!aabbs_overlap(boxes[tree->items[i]], box)) {
+          misses++;
+          continue;
+        }
+        hits++;
+        result = visit(tree->items[i], context);
+      }
+    } else {
+      stack[top++] = node->left;
+      stack[top++] = node->right;
+    }
+  }
+  add_aabb_stats(hits, misses);
+  return result;
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <data.h>
+
+// axis aligned bounding box
+typedef struct {
+  Vector min;
+  Vector max;
+} Aabb;
+
+// uniform grid of square cells over a set of boxes; the broad phase in front of the exact SAT tests
+// every box is listed in every cell it touches, grouped by cell, so the boxes in cell c
+// are items[cell_start[c]] up to (but not including) items[cell_start[c + 1]]
+typedef struct {
+  Vector origin;    // lower left corner of cell 0
+  double cell_size;
+  int columns;
+  int rows;
+  int *cell_start;
+  int *items;       // indices into the boxes the grid was built from
+} AabbGrid;
+
+// how well the bounding box tests in front of SAT do their job, counted over every grid and tree query
+// every pair of rectangles is counted once, however many cells or tree nodes it shows up in
+typedef struct {
+  long long hits;   // pairs whose boxes overlap, so they were handed on to SAT
+  long long misses; // pairs thrown out by their boxes, so SAT never ran on them
+} AabbStats;
+
+AabbStats aabb_stats(void);
+void reset_aabb_stats(void);
+Aabb aabb_with_slack(Vector min, Vector max);
+int aabbs_overlap(Aabb a, Aabb b);
+AabbGrid build_aabb_grid(const Aabb *boxes, int count);
+void free_aabb_grid(AabbGrid grid);
+int aabb_grid_pairs(const AabbGrid *grid, const Aabb *boxes, int (*visit)(int a, const int *others, int count, void *context), void *context);
+
+// bounding volume hierarchy over boxes, built top down by splitting at the median of the longest axis
+typedef struct {
+  Aabb box;  // bounds of everything below this node
+  int left;  // child nodes, -1 for a leaf
+  int right;
+  int first; // a leaf holds items[first] up to (but not including) items[first + count]
+  int count;
+} AabbTreeNode;
+
+typedef struct {
+  AabbTreeNode *nodes; // nodes[0] is the root
+  int node_count;
+  int *items;          // indices into the boxes the tree was built from
+  int item_count;
+} AabbTree;
+
+AabbTree build_aabb_tree(const Aabb *boxes, const int *items, int count);
+void free_aabb_tree(AabbTree tree);
+int aabb_tree_query(const AabbTree *tree, const Aabb *boxes, Aabb box, int (*visit)(int item, void *context), void *context);
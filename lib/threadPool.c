@@ -0,0 +1,191 @@
+#include "threadPool.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+typedef struct {
+  TaskFunction function;
+  void *argument;
+} Task;
+
+// the owner takes tasks from the back, thieves from the front
+typedef struct {
+  pthread_mutex_t lock;
+  Task *tasks;
+  int head;
+  int tail;
+  int capacity;
+} TaskQueue;
+
+typedef struct {
+  ThreadPool *pool;
+  int id;
+} Worker;
+
+struct ThreadPool {
+  pthread_t *threads;
+  Worker *workers;
+  TaskQueue *queues;
+  int thread_count;
+  pthread_mutex_t lock;        // guards everything below
+  pthread_cond_t work_available;
+  pthread_cond_t all_done;
+  int queued;                  // tasks waiting in a queue that no worker has claimed yet
+  int pending;                 // tasks submitted but not finished
+  int next_queue;              // submissions go round robin over the queues
+  int stopping;
+};
+
+static void queue_push(TaskQueue *queue, Task task) {
+  pthread_mutex_lock(&queue->lock);
+  if (queue->tail == queue->capacity) {
+    // slide the live tasks to the front, and grow if that did not make room
+    int live = queue->tail - queue->head;
+    for (int i = 0; i < live; i++) queue->tasks[i] = queue->tasks[queue->head + i];
+    queue->head = 0;
+    queue->tail = live;
+    if (live == queue->capacity) {
+      queue->capacity = queue->capacity > 0 ? queue->capacity * 2 : 16;
+      Task *tasks = realloc(queue->tasks, sizeof(Task) * queue->capacity);
+      if (!tasks) {
+        printf("ERROR: Memory reallocation failed!\n");
+        exit(1);
+      }
+      queue->tasks = tasks;
+    }
+  }
+  queue->tasks[queue->tail++] = task;
+  pthread_mutex_unlock(&queue->lock);
+}
+
+// take a task from the back (own queue) or the front (stealing); returns 0 if the queue is empty
+static int queue_take(TaskQueue *queue, int steal, Task *out) {
+  pthread_mutex_lock(&queue->lock);
+  int found = queue->head < queue->tail;
+  if (found) {
+    *out = steal ? queue->tasks[queue->head++] : queue->tasks[--queue->tail];
+    if (queue->head == queue->tail) queue->head = queue->tail = 0;
+  }
+  pthread_mutex_unlock(&queue->lock);
+  return found;
+}
+
+// own queue first, then every other queue in turn
+static int find_task(ThreadPool *pool, int id, Task *out) {
+  if (queue_take(&pool->queues[id], 0, out)) return 1;
+  for (int i = 1; i < pool->thread_count; i++) {
+    if (queue_take(&pool->queues[(id + i) % pool->thread_count], 1, out)) return 1;
+  }
+  return 0;
+}
+
+static void *worker_main(void *argument) {
+  Worker *worker = argument;
+  ThreadPool *pool = worker->pool;
+  while (1) {
+    pthread_mutex_lock(&pool->lock);
+    while (pool->queued == 0 && !pool->stopping) {
+      pthread_cond_wait(&pool->work_available, &pool->lock);
+    }
+    if (pool->queued == 0 && pool->stopping) {
+      pthread_mutex_unlock(&pool->lock);
+      return NULL;
+    }
+    // claim one of the queued tasks before looking for it, so no other worker goes after the same one
+    pool->queued--;
+    pthread_mutex_unlock(&pool->lock);
+
+    Task task;
+    if (!find_task(pool, worker->id, &task)) {
+      // a worker that claimed later stole the task from under us; hand the claim back
+      pthread_mutex_lock(&pool->lock);
+      pool->queued++;
+      pthread_cond_signal(&pool->work_available);
+      pthread_mutex_unlock(&pool->lock);
+      continue;
+    }
+
+    task.function(task.argument);
+
+    pthread_mutex_lock(&pool->lock);
+    if (--pool->pending == 0) pthread_cond_broadcast(&pool->all_done);
+    pthread_mutex_unlock(&pool->lock);
+  }
+}
+
+// start a pool with thread_count workers; 0 or less means one per online cpu
+ThreadPool *create_thread_pool(int thread_count) {
+  if (thread_count <= 0) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    thread_count = cpus > 0 ? (int)cpus : 1;
+  }
+  ThreadPool *pool = calloc(1, sizeof(ThreadPool));
+  pool->thread_count = thread_count;
+  pool->threads = malloc(sizeof(pthread_t) * thread_count);
+  pool->workers = malloc(sizeof(Worker) * thread_count);
+  pool->queues = calloc(thread_count, sizeof(TaskQueue));
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->work_available, NULL);
+  pthread_cond_init(&pool->all_done, NULL);
+  for (int i = 0; i < thread_count; i++) {
+    pthread_mutex_init(&pool->queues[i].lock, NULL);
+  }
+  for (int i = 0; i < thread_count; i++) {
+    pool->workers[i] = (Worker){ pool, i };
+    if (pthread_create(&pool->threads[i], NULL, worker_main, &pool->workers[i]) != 0) {
+      printf("ERROR: Failed to start worker thread!\n");
+      exit(1);
+    }
+  }
+  return pool;
+}
+
+// finish every submitted task, then stop the workers
+void free_thread_pool(ThreadPool *pool) {
+  if (!pool) return;
+  pthread_mutex_lock(&pool->lock);
+  pool->stopping = 1;
+  pthread_cond_broadcast(&pool->work_available);
+  pthread_mutex_unlock(&pool->lock);
+  for (int i = 0; i < pool->thread_count; i++) {
+    pthread_join(pool->threads[i], NULL);
+  }
+  for (int i = 0; i < pool->thread_count; i++) {
+    pthread_mutex_destroy(&pool->queues[i].lock);
+    free(pool->queues[i].tasks);
+  }
+  pthread_mutex_destroy(&pool->lock);
+  pthread_cond_destroy(&pool->work_available);
+  pthread_cond_destroy(&pool->all_done);
+  free(pool->queues);
+  free(pool->workers);
+  free(pool->threads);
+  free(pool);
+}
+
+int thread_pool_size(const ThreadPool *pool) {
+  return pool->thread_count;
+}
+
+// queue a task; it runs on some worker at some point before thread_pool_wait returns
+void thread_pool_submit(ThreadPool *pool, TaskFunction function, void *argument) {
+  pthread_mutex_lock(&pool->lock);
+  pool->pending++;
+  int queue = pool->next_queue;
+  pool->next_queue = (pool->next_queue + 1) % pool->thread_count;
+  // the task is in its queue before it is counted, so every claim has a task behind it
+  queue_push(&pool->queues[queue], (Task){ function, argument });
+  pool->queued++;
+  pthread_cond_signal(&pool->work_available);
+  pthread_mutex_unlock(&pool->lock);
+}
+
+// block until every task submitted so far has finished
+void thread_pool_wait(ThreadPool *pool) {
+  pthread_mutex_lock(&pool->lock);
+  while (pool->pending > 0) {
+    pthread_cond_wait(&pool->all_done, &pool->lock);
+  }
+  pthread_mutex_unlock(&pool->lock);
+}
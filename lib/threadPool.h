@@ -0,0 +1,14 @@
+#pragma once
+
+typedef void (*TaskFunction)(void *argument);
+
+// small work-stealing thread pool
+// every worker has its own queue; submitted tasks are spread over the queues and a worker
+// whose queue runs dry takes tasks from the front of the others'
+typedef struct ThreadPool ThreadPool;
+
+ThreadPool *create_thread_pool(int thread_count);
+void free_thread_pool(ThreadPool *pool);
+int thread_pool_size(const ThreadPool *pool);
+void thread_pool_submit(ThreadPool *pool, TaskFunction function, void *argument);
+void thread_pool_wait(ThreadPool *pool);
@@ -1,10 +1,14 @@
 #include "validate.h"
 #include "calculations.h"
 #include "data.h"
+#include "endpoints.h"
+#include "spatial.h"
 #include <float.h>
 #include <math.h>
 #include <stdlib.h>
+#include <stdatomic.h>
 #include <string.h>
+#include <time.h>
 
 // macros to help return results
 #define OK (ValidationResult){ Ok, NoError }
@@ -28,15 +32,32 @@ const char *validation_error_message(LotValidationError error) {
   }
 }
 
-// main validation function; sequentially checks each rule
-ValidationResult validate_lot(const Lot lot) {
-  // Rule 0: Each path must have a non-zero length
+// helper function for rule 0: is there a path with no length?
+static int has_zero_length_path(const Lot lot) {
   for (int i = 0; i < lot.path_count; i++) {
     double path_length = sqrt(lot.paths[i].vector.x * lot.paths[i].vector.x + lot.paths[i].vector.y * lot.paths[i].vector.y);
     if (path_length < DBL_EPSILON) {
-      return ERR(ZeroLengthPath);
+      return 1;
     }
   }
+  return 0;
+}
+
+// helper function for rule 9: is there a name longer than 10 characters?
+static int has_too_long_name(const Lot lot) {
+  for (int i = 0; i < lot.space_count; i++) {
+    if (strlen(lot.spaces[i].name) > 10) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+// main validation function; sequentially checks each rule
+ValidationResult validate_lot(const Lot lot) {
+  // Rule 0: Each path must have a non-zero length
+  if (has_zero_length_path(lot))
+    return ERR(ZeroLengthPath);
 
   // Rule 1: Each path must connect
   if (!paths_connected(lot))
@@ -68,99 +89,49 @@ ValidationResult validate_lot(const Lot lot) {
   if (!levels_have_ups_and_downs(lot)) return ERR(LevelsMissingUpsOrDowns);
 
   // Rule 9: Space name length must not exceed 10 characters
-  for (int i = 0; i < lot.space_count; i++) {
-    if (strlen(lot.spaces[i].name) > 10) {
-      return ERR(SpaceNameTooLong);
-    }
-  }
+  if (has_too_long_name(lot))
+    return ERR(SpaceNameTooLong);
   
   return OK;
 }
 
+// does the start point of path i meet the end of a path, the entrance, an up or a down?
+static int path_start_connected(const Lot lot, const EndpointIndex *index, int i) {
+  int e = endpoint_index_of(index, lot.paths[i].start_point);
+  const Endpoint *start = &index->endpoints[e];
+  if (start->incoming_count > 0 || start->is_up || start->is_down) return 1;
+  if (e == endpoint_index_of(index, lot.entrance)) return 1;
+  // still nothing? then the path is an orphan.
+  return 0;
+}
+
+// does at least one path start or end at this location?
+// this can either be "to" or "from" an up/down since non-entrance levels tend to have
+// paths exclusively going from ups/downs rather than to them.
+static int location_meets_path(const EndpointIndex *index, Location location) {
+  int e = endpoint_index_of(index, location);
+  return e != -1 && index->endpoints[e].incoming_count + index->endpoints[e].outgoing_count > 0;
+}
+
 // helper function to check if all paths are connected
+// the endpoint index hashes every location once, so each lookup below is constant time
+// instead of a scan over every path, up and down
 int paths_connected(const Lot lot) {
-  int connected = 0;
-  Location* endpoints = get_all_endpoints(lot.paths, lot.path_count); // get every path's endpoint
-  int amount_of_endpoints = lot.path_count;
-  // for each path we check:
-  for (int i = 0; i < lot.path_count; i++) {
-    int cur = connected;
-    // is the start point identical to any endpoint?
-    for (int j = 0; j < amount_of_endpoints; j++) {
-      Location endpoint = endpoints[j];
-      if (compare_locations(lot.paths[i].start_point, endpoint)) {
-        connected++;
-        break;
-      }
-    }
-    if (cur != connected)
-      continue;
-    // no? then is the start point the entrance?
-    if (compare_locations(lot.paths[i].start_point, lot.entrance)) {
-      connected++;
-      continue;
-    }
-    // no? then is the start point an up?
-    for (int k = 0; k < lot.up_count; k++) {
-      if (compare_locations(lot.paths[i].start_point, lot.ups[k])) {
-        connected++;
-        break;
-      }
-    }
-    if (cur != connected)
-      continue;
-    // no? then is the start point a down?
-    for (int l = 0; l < lot.down_count; l++) {
-      if (compare_locations(lot.paths[i].start_point, lot.downs[l])) {
-        connected++;
-        break;
-      }
-    }
-    // still nothing? then the path is an orphan.
-    // connected will be less than path_count,
-    // causing the function to return 0.
+  EndpointIndex index = build_endpoint_index(lot);
+  int connected = 1;
+  // for each path we check if it starts somewhere it can be reached from
+  for (int i = 0; i < lot.path_count && connected; i++) {
+    connected = path_start_connected(lot, &index, i);
   }
-
   // then, for every up and down, we need to check they connect to at least one path.
-  // this can either be "to" or "from" the up/down since non-entrance levels tend to have
-  // paths exclusively going from ups/downs rather than to them.
-  
-  // for each up
-  for (int m = 0; m < lot.up_count; m++) {
-    // is there at least one path connecting to this up?
-    for (int n = 0; n < lot.path_count; n++) {
-      // first check against every endpoint
-      Location endpoint = endpoints[n];
-      if (compare_locations(lot.ups[m], endpoint)) {
-        connected++;
-        break;
-      }
-      // then check against every start point
-      Location startpoint = lot.paths[n].start_point;
-      if (compare_locations(lot.ups[m], startpoint)) {
-        connected++;
-        break;
-      }
-    }
+  for (int m = 0; m < lot.up_count && connected; m++) {
+    connected = location_meets_path(&index, lot.ups[m]);
   }
-  for (int o = 0; o < lot.down_count; o++) {
-    // is there at least one path connecting to this down?
-    for (int p = 0; p < lot.path_count; p++) {
-      Location endpoint = endpoints[p];
-      if (compare_locations(lot.downs[o], endpoint)) {
-        connected++;
-        break;
-      }
-      // then check against every start point
-      Location startpoint = lot.paths[p].start_point;
-      if (compare_locations(lot.downs[o], startpoint)) {
-        connected++;
-        break;
-      }
-    }
+  for (int o = 0; o < lot.down_count && connected; o++) {
+    connected = location_meets_path(&index, lot.downs[o]);
   }
-  free(endpoints);
-  return connected == lot.path_count + lot.up_count + lot.down_count; 
+  free_endpoint_index(index);
+  return connected;
 }
 
 // helper function to get all path endpoints
@@ -172,48 +143,100 @@ Location *get_all_endpoints(Path *paths, int path_count) {
   return endpoints;
 }
 
-// helper function to check if two rectangles are separated along any axis
-// returns 1 if separated, 0 if overlapping
+// the spaces of one level, as handed to the overlap check below
+typedef struct {
+  const SpaceGeometry *geometry;
+  const int *spaces;  // space index of every box in the grid
+  Rectangle *rects;   // scratch room for one batch of rectangles
+  int *separated;
+} OverlapContext;
+
+static int level_spaces_collide(int a, const int *others, int count, void *context) {
+  const OverlapContext *level = context;
+  for (int k = 0; k < count; k++) {
+    level->rects[k] = level->geometry[level->spaces[others[k]]].rect;
+  }
+  // by the separating axis theorem, if we find one axis where they do not overlap, we can be sure there is no collision.
+  return separating_axis_batch(level->geometry[level->spaces[a]].rect, level->rects, count, level->separated) > 0;
+}
+
+// check the given spaces (all on one level) for overlaps
+// only spaces whose bounding boxes share a grid cell are compared with SAT, instead of every pair
+static int level_has_overlap(const SpaceGeometry *geometry, const int *spaces, int count) {
+  if (count < 2) return 0;
+  Aabb *boxes = malloc(sizeof(Aabb) * (count + 1));
+  Rectangle *rects = malloc(sizeof(Rectangle) * (count + 1));
+  int *separated = malloc(sizeof(int) * (count + 1));
+  for (int i = 0; i < count; i++) {
+    boxes[i] = aabb_with_slack(geometry[spaces[i]].min, geometry[spaces[i]].max);
+  }
+
+  AabbGrid grid = build_aabb_grid(boxes, count);
+  OverlapContext context = { geometry, spaces, rects, separated };
+  int overlap = aabb_grid_pairs(&grid, boxes, level_spaces_collide, &context);
+  free_aabb_grid(grid);
+
+  free(boxes);
+  free(rects);
+  free(separated);
+  return overlap;
+}
+
+// helper function to check if any two spaces on the same level overlap
+// returns 1 if an overlap is found, 0 otherwise
 int spaces_overlap(const Lot lot) {
-  // using get_space_rectangle we get the rectangles of each space
-  for (int i = 0; i < lot.space_count; i++) {
-    Rectangle rect1 = get_space_rectangle(lot.spaces[i]);
-    // we then wanna compare it to every other space's rectangle
-    for (int j = i + 1; j < lot.space_count; j++) {
-      if (lot.spaces[i].location.level != lot.spaces[j].location.level) { continue; } // only compare spaces on the same level
-      Rectangle rect2 = get_space_rectangle(lot.spaces[j]);
-      // by the separating axis theorem, if we find one axis where they do not overlap, we can be sure there is no collision.
-      if (!separating_axis(rect1, rect2)) {
-        return 1; // overlap found
-      }
-    }
+  // lots built by hand get their geometry computed just for this
+  SpaceGeometry *geometry = lot.geometry ? lot.geometry : build_space_geometry(lot);
+
+  // only spaces on the same level can overlap, so the level table hands over one level at a time
+  LevelTable *levels = lot.levels ? lot.levels : build_level_table(lot);
+  int overlap = 0;
+  for (int l = 0; l < levels->level_span && !overlap; l++) {
+    int count;
+    const int *spaces = level_spaces(levels, levels->min_level + l, &count);
+    overlap = level_has_overlap(geometry, spaces, count);
   }
-  return 0; // no overlaps found
+
+  if (levels != lot.levels) free_level_table(levels);
+  if (geometry != lot.geometry) free(geometry);
+  return overlap;
 };
 
+// does any space from first up to (not including) last touch a corridor of the index?
+static int space_range_encroaches(const Lot lot, const CorridorIndex *index, int first, int last) {
+  for (int j = first; j < last; j++) {
+    SpaceGeometry space = lot_space_geometry(lot, j);
+    if (corridors_touching_space(index, &space, lot.spaces[j].location.level, NULL) > 0) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+// does every space from first up to (not including) last touch a corridor of the index?
+static int space_range_accessible(const Lot lot, const CorridorIndex *index, int first, int last) {
+  for (int i = first; i < last; i++) {
+    SpaceGeometry space = lot_space_geometry(lot, i);
+    if (corridors_touching_space(index, &space, lot.spaces[i].location.level, NULL) == 0) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
 // helper function to check if any spaces encroach within margin of any path
 int spaces_encroach_path(const Lot lot, double margin) {
   // for each path, we create a "corridor" rectangle representing the path with margin on both sides. 
   // then we check if any space's rectangle overlaps with this corridor.
-  
-  // for each path
-  for (int i = 0; i < lot.path_count; i++) {
-    Rectangle path_corridor = get_path_corridor(lot.paths[i], margin);
-    
-    // check against each space
-    for (int j = 0; j < lot.space_count; j++) {
-      // only check spaces on the same level as the path
-      if (lot.spaces[j].location.level != lot.paths[i].start_point.level) { continue; }
-      
-      Rectangle space_rect = get_space_rectangle(lot.spaces[j]);
-      
-      // if no separating axis is found, the rectangles overlap
-      if (!separating_axis(path_corridor, space_rect)) {
-        return 1; // encroachment found
-      }
-    }
-  }
-  return 0; // no encroachments found
+  // the corridor index hands each space only the corridors on its level that are near it
+  const CorridorIndex *index = lot_corridor_index(lot, margin);
+  CorridorIndex *built = index ? NULL : build_corridor_index(lot, margin);
+  if (built) index = built;
+
+  int encroaches = space_range_encroaches(lot, index, 0, lot.space_count);
+
+  free_corridor_index(built);
+  return encroaches; // 1 if an encroachment was found
 }
 
 // helper function to get the corridor rectangle for a path with margin
@@ -262,30 +285,127 @@ Rectangle get_path_corridor(const Path path, double margin) {
 
 // helper function to check if all spaces are accessible from at least one path
 int spaces_accessible(const Lot lot, double max_distance) {
+  const CorridorIndex *index = lot_corridor_index(lot, max_distance);
+  CorridorIndex *built = index ? NULL : build_corridor_index(lot, max_distance);
+  if (built) index = built;
+
   // for each space, check if it overlaps with at least one path's accessibility corridor
-  for (int i = 0; i < lot.space_count; i++) {
-    Rectangle space_rect = get_space_rectangle(lot.spaces[i]);
-    int accessible = 0;
-
-    // check against each path
-    for (int j = 0; j < lot.path_count; j++) {
-      // only check paths on the same level as the space
-      if (lot.spaces[i].location.level != lot.paths[j].start_point.level) { continue; }
-      
-      Rectangle path_corridor = get_path_corridor(lot.paths[j], max_distance);
-      
-      // if no separating axis found → space overlaps with corridor → accessible
-      if (!separating_axis(path_corridor, space_rect)) {
-        accessible = 1;
-        break;
-      }
+  int accessible = space_range_accessible(lot, index, 0, lot.space_count);
+
+  free_corridor_index(built);
+  return accessible; // 0 if some space is not accessible from any path
+}
+
+// === Corridor index ===
+
+// build the corridors of every path at a margin, and a tree over them per level
+CorridorIndex *build_corridor_index(const Lot lot, double margin) {
+  CorridorIndex *index = malloc(sizeof(CorridorIndex));
+  index->margin = margin;
+  index->corridors = malloc(sizeof(Rectangle) * (lot.path_count + 1));
+  index->boxes = malloc(sizeof(Aabb) * (lot.path_count + 1));
+  index->min_level = 0;
+  index->level_span = 0;
+  index->trees = NULL;
+  if (lot.path_count == 0) return index;
+
+  int max_level = lot.paths[0].start_point.level;
+  index->min_level = max_level;
+  for (int i = 0; i < lot.path_count; i++) {
+    Rectangle corridor = get_path_corridor(lot.paths[i], margin);
+    Vector min = corridor.corner[0], max = corridor.corner[0];
+    for (int c = 1; c < 4; c++) {
+      min.x = fmin(min.x, corridor.corner[c].x);
+      min.y = fmin(min.y, corridor.corner[c].y);
+      max.x = fmax(max.x, corridor.corner[c].x);
+      max.y = fmax(max.y, corridor.corner[c].y);
     }
+    index->corridors[i] = corridor;
+    index->boxes[i] = aabb_with_slack(min, max);
+    int level = lot.paths[i].start_point.level;
+    if (level < index->min_level) index->min_level = level;
+    if (level > max_level) max_level = level;
+  }
+
+  // one tree per level, each over the paths on that level
+  index->level_span = max_level - index->min_level + 1;
+  index->trees = malloc(sizeof(AabbTree) * index->level_span);
+  LevelTable *levels = lot.levels ? lot.levels : build_level_table(lot);
+  for (int l = 0; l < index->level_span; l++) {
+    int count;
+    const int *paths = level_paths(levels, index->min_level + l, &count);
+    index->trees[l] = build_aabb_tree(index->boxes, paths, count);
+  }
+  if (levels != lot.levels) free_level_table(levels);
+  return index;
+}
+
+void free_corridor_index(CorridorIndex *index) {
+  if (!index) return;
+  for (int l = 0; l < index->level_span; l++) {
+    free_aabb_tree(index->trees[l]);
+  }
+  free(index->trees);
+  free(index->corridors);
+  free(index->boxes);
+  free(index);
+}
+
+// the corridor index a loaded lot keeps for a margin, or NULL if it has none
+const CorridorIndex *lot_corridor_index(const Lot lot, double margin) {
+  if (lot.clearance_corridors && lot.clearance_corridors->margin == margin) return lot.clearance_corridors;
+  if (lot.access_corridors && lot.access_corridors->margin == margin) return lot.access_corridors;
+  return NULL;
+}
 
-    if (!accessible) {
-      return 0; // this space is not accessible from any path
+static int collect_corridor(int path, void *context) {
+  int *candidates = context;
+  candidates[++candidates[0]] = path; // candidates[0] holds the count
+  return 0;
+}
+
+// find the paths on a level whose corridor overlaps a space
+// the path indices go into out_paths in increasing order (it needs room for every path) and their
+// count is returned; if out_paths is NULL this only returns 1 if there is one, or 0 if there is none
+int corridors_touching_space(const CorridorIndex *index, const SpaceGeometry *space, int level, int *out_paths) {
+  int l = level - index->min_level;
+  if (l < 0 || l >= index->level_span) return 0;
+
+  // the tree finds the corridors whose bounding box overlaps the space...
+  const AabbTree *tree = &index->trees[l];
+  int *candidates = malloc(sizeof(int) * (tree->item_count + 1));
+  candidates[0] = 0;
+  aabb_tree_query(tree, index->boxes, aabb_with_slack(space->min, space->max), collect_corridor, candidates);
+  int candidate_count = candidates[0];
+
+  // ...and SAT tests all of those against the space in one batch
+  Rectangle *rects = malloc(sizeof(Rectangle) * (candidate_count + 1));
+  int *separated = malloc(sizeof(int) * (candidate_count + 1));
+  for (int k = 0; k < candidate_count; k++) {
+    rects[k] = index->corridors[candidates[k + 1]];
+  }
+  int count = separating_axis_batch(space->rect, rects, candidate_count, separated);
+
+  if (out_paths) {
+    int found = 0;
+    for (int k = 0; k < candidate_count; k++) {
+      // if no separating axis found → space overlaps with corridor
+      if (!separated[k]) out_paths[found++] = candidates[k + 1];
+    }
+    // the tree hands the paths out in no particular order, but callers expect lot order
+    for (int i = 1; i < count; i++) {
+      int path = out_paths[i], j = i;
+      for (; j > 0 && out_paths[j - 1] > path; j--) out_paths[j] = out_paths[j - 1];
+      out_paths[j] = path;
     }
+  } else {
+    count = count > 0;
   }
-  return 1; // all spaces are accessible
+
+  free(candidates);
+  free(rects);
+  free(separated);
+  return count;
 }
 
 // helper function to check if entrance and POI are on valid levels
@@ -304,16 +424,29 @@ int has_valid_entrance_and_poi(const Lot lot) {
 }
 
 // helper function to check if all space names are unique
+// every space goes into a hash table keyed by its name, so a duplicate is found in one pass
 int spaces_have_unique_names(const Lot lot) {
-  for (int i = 0; i < lot.space_count; i++) {
-    for (int j = i + 1; j < lot.space_count; j++) {
+  // the table is kept at most half full so probe sequences stay short
+  int slot_count = 1;
+  while (slot_count < 2 * lot.space_count) slot_count <<= 1;
+  int *slots = malloc(sizeof(int) * slot_count); // space index, -1 if empty
+  for (int s = 0; s < slot_count; s++) slots[s] = -1;
+
+  int unique = 1;
+  for (int i = 0; i < lot.space_count && unique; i++) {
+    int slot = (int)(hash_name(lot.spaces[i].name) & (uint64_t)(slot_count - 1));
+    while (slots[slot] != -1) {
       // compare names using strcmp
-      if (strcmp(lot.spaces[i].name, lot.spaces[j].name) == 0) {
-        return 0; // duplicate name found
+      if (strcmp(lot.spaces[slots[slot]].name, lot.spaces[i].name) == 0) {
+        unique = 0; // duplicate name found
+        break;
       }
+      slot = (slot + 1) & (slot_count - 1); // linear probing
     }
+    if (unique) slots[slot] = i;
   }
-  return 1; // all names are unique
+  free(slots);
+  return unique; // 1 if all names are unique
 }
 
 // helper function to check if the number of ups and downs is correct for the level count
@@ -371,3 +504,357 @@ int levels_have_ups_and_downs(const Lot lot) {
   free(has_down);
   return 1;
 }
+
+// === Parallel validation ===
+// every rule runs at once on the pool; the big ones are split over levels or ranges of spaces.
+// the result is the error of the lowest numbered rule that fails, just like validate_lot.
+
+// rule n fails with rule_errors[n]
+static const LotValidationError rule_errors[VALIDATION_RULE_COUNT] = {
+  ZeroLengthPath, PathNotConnected, SpacesOverlap, SpacesEncroachPath, SpacesInaccessible,
+  InvalidEntranceOrPOI, DuplicateSpaceNames, IncorrectUpDownCount, LevelsMissingUpsOrDowns, SpaceNameTooLong
+};
+
+// spaces per task for the rules that go space by space
+static const int spaces_per_task = 256;
+
+static double now_ms(void) {
+  struct timespec time;
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return time.tv_sec * 1e3 + time.tv_nsec / 1e6;
+}
+
+// shared by every task of one validation
+typedef struct {
+  Lot lot;            // with geometry and corridor indexes filled in
+  const int *order;   // spaces grouped by level (see LevelTable), for rule 2
+  atomic_int first_failed; // lowest rule known to fail; rules above it can skip their work
+} ParallelValidation;
+
+// one piece of one rule
+typedef struct {
+  ParallelValidation *validation;
+  int rule;
+  int first; // rule 2: a run of order; rules 3 and 4: a range of spaces
+  int last;
+  int failed;
+  double start_ms;
+  double end_ms;
+} RuleTask;
+
+static int run_rule(const RuleTask *task) {
+  const Lot lot = task->validation->lot;
+  switch (task->rule) {
+    case 0: return has_zero_length_path(lot);
+    case 1: return !paths_connected(lot);
+    case 2: return level_has_overlap(lot.geometry, task->validation->order + task->first, task->last - task->first);
+    case 3: return space_range_encroaches(lot, lot.clearance_corridors, task->first, task->last);
+    case 4: return !space_range_accessible(lot, lot.access_corridors, task->first, task->last);
+    case 5: return !has_valid_entrance_and_poi(lot);
+    case 6: return !spaces_have_unique_names(lot);
+    case 7: return !has_correct_up_down_count(lot);
+    case 8: return !levels_have_ups_and_downs(lot);
+    default: return has_too_long_name(lot);
+  }
+}
+
+static void run_rule_task(void *argument) {
+  RuleTask *task = argument;
+  task->start_ms = now_ms();
+  // once a lower rule has failed, this one cannot change the result any more
+  if (atomic_load(&task->validation->first_failed) > task->rule) {
+    task->failed = run_rule(task);
+    if (task->failed) {
+      int lowest = atomic_load(&task->validation->first_failed);
+      while (lowest > task->rule && !atomic_compare_exchange_weak(&task->validation->first_failed, &lowest, task->rule)) {}
+    }
+  }
+  task->end_ms = now_ms();
+}
+
+// validate a lot on a thread pool; gives exactly the same result as validate_lot
+// if out_timing is not NULL it receives the wall time of every rule (from its first piece starting to its last one ending)
+ValidationResult validate_lot_parallel(const Lot lot, ThreadPool *pool, ValidationTiming *out_timing) {
+  double start_ms = now_ms();
+
+  // everything the tasks share is built up front, so no task builds its own copy
+  // (lots built by hand get them just for this validation)
+  SpaceGeometry *built_geometry = lot.geometry ? NULL : build_space_geometry(lot);
+  CorridorIndex *built_clearance = lot_corridor_index(lot, path_clearance) ? NULL : build_corridor_index(lot, path_clearance);
+  CorridorIndex *built_access = lot_corridor_index(lot, path_accessibility) ? NULL : build_corridor_index(lot, path_accessibility);
+  ParallelValidation validation;
+  validation.lot = lot;
+  if (built_geometry) validation.lot.geometry = built_geometry;
+  // the lot is a copy, so pointing it at the indexes for the right margins changes nothing for the caller
+  validation.lot.clearance_corridors = built_clearance ? built_clearance : (CorridorIndex *)lot_corridor_index(lot, path_clearance);
+  validation.lot.access_corridors = built_access ? built_access : (CorridorIndex *)lot_corridor_index(lot, path_accessibility);
+  LevelTable *built_levels = lot.levels ? NULL : build_level_table(lot);
+  const LevelTable *levels = built_levels ? built_levels : lot.levels;
+  validation.order = levels->space_order;
+  atomic_init(&validation.first_failed, VALIDATION_RULE_COUNT);
+
+  // one task per level for rule 2, one per block of spaces for rules 3 and 4, one for every other rule
+  int space_blocks = (lot.space_count + spaces_per_task - 1) / spaces_per_task;
+  RuleTask *tasks = malloc(sizeof(RuleTask) * (VALIDATION_RULE_COUNT + levels->level_span + 2 * space_blocks));
+  int task_count = 0;
+  for (int rule = 0; rule < VALIDATION_RULE_COUNT; rule++) {
+    if (rule == 2) {
+      for (int l = 0; l < levels->level_span; l++) {
+        if (levels->levels[l].space_count == 0) continue;
+        tasks[task_count++] = (RuleTask){ &validation, rule, levels->space_start[l], levels->space_start[l + 1], 0, 0, 0 };
+      }
+    } else if (rule == 3 || rule == 4) {
+      for (int first = 0; first < lot.space_count; first += spaces_per_task) {
+        int last = first + spaces_per_task < lot.space_count ? first + spaces_per_task : lot.space_count;
+        tasks[task_count++] = (RuleTask){ &validation, rule, first, last, 0, 0, 0 };
+      }
+    } else {
+      tasks[task_count++] = (RuleTask){ &validation, rule, 0, 0, 0, 0, 0 };
+    }
+  }
+  for (int t = 0; t < task_count; t++) {
+    thread_pool_submit(pool, run_rule_task, &tasks[t]);
+  }
+  thread_pool_wait(pool);
+
+  int first_failed = atomic_load(&validation.first_failed);
+  if (out_timing) {
+    for (int rule = 0; rule < VALIDATION_RULE_COUNT; rule++) {
+      double rule_start = 0.0, rule_end = 0.0;
+      int seen = 0;
+      for (int t = 0; t < task_count; t++) {
+        if (tasks[t].rule != rule) continue;
+        if (!seen || tasks[t].start_ms < rule_start) rule_start = tasks[t].start_ms;
+        if (!seen || tasks[t].end_ms > rule_end) rule_end = tasks[t].end_ms;
+        seen = 1;
+      }
+      out_timing->rule_ms[rule] = seen ? rule_end - rule_start : 0.0;
+    }
+  }
+
+  free(tasks);
+  free_level_table(built_levels);
+  free(built_geometry);
+  free_corridor_index(built_clearance);
+  free_corridor_index(built_access);
+  if (out_timing) out_timing->total_ms = now_ms() - start_ms;
+
+  if (first_failed < VALIDATION_RULE_COUNT) return ERR(rule_errors[first_failed]);
+  return OK;
+}
+
+// === Validation report ===
+// goes over every rule once and keeps going after a failure, so a big lot can be fixed in one go
+// instead of one validate_lot run per error. the issues come out in rule order, so the first one
+// is always the error validate_lot would have returned.
+
+static void report_issue(ValidationReport *report, LotValidationError error, int space, int other_space, int path, int level) {
+  if (report->issue_count == report->capacity) {
+    report->capacity = report->capacity ? 2 * report->capacity : 16;
+    report->issues = realloc(report->issues, sizeof(ValidationIssue) * report->capacity);
+  }
+  report->issues[report->issue_count++] = (ValidationIssue){ error, space, other_space, path, level };
+}
+
+// orders the issues of one rule by their space and then their other space
+static int compare_space_issues(const void *a, const void *b) {
+  const ValidationIssue *x = a, *y = b;
+  if (x->space != y->space) return x->space < y->space ? -1 : 1;
+  return (x->other_space > y->other_space) - (x->other_space < y->other_space);
+}
+
+// like level_spaces_collide, but writes down every colliding pair instead of stopping at the first
+typedef struct {
+  OverlapContext level;
+  int level_number;
+  ValidationReport *report;
+} OverlapReportContext;
+
+static int report_level_collisions(int a, const int *others, int count, void *context) {
+  OverlapReportContext *overlaps = context;
+  const OverlapContext *level = &overlaps->level;
+  for (int k = 0; k < count; k++) {
+    level->rects[k] = level->geometry[level->spaces[others[k]]].rect;
+  }
+  separating_axis_batch(level->geometry[level->spaces[a]].rect, level->rects, count, level->separated);
+  for (int k = 0; k < count; k++) {
+    if (level->separated[k]) continue;
+    int first = level->spaces[a], second = level->spaces[others[k]];
+    if (first > second) { int swap = first; first = second; second = swap; }
+    report_issue(overlaps->report, SpacesOverlap, first, second, -1, overlaps->level_number);
+  }
+  return 0; // keep going
+}
+
+// report every overlapping pair on every level
+static void report_overlaps(const Lot lot, const SpaceGeometry *geometry, ValidationReport *report) {
+  LevelTable *levels = lot.levels ? lot.levels : build_level_table(lot);
+  Aabb *boxes = malloc(sizeof(Aabb) * (lot.space_count + 1));
+  Rectangle *rects = malloc(sizeof(Rectangle) * (lot.space_count + 1));
+  int *separated = malloc(sizeof(int) * (lot.space_count + 1));
+  int first_issue = report->issue_count;
+  for (int l = 0; l < levels->level_span; l++) {
+    int count;
+    const int *spaces = level_spaces(levels, levels->min_level + l, &count);
+    if (count < 2) continue;
+    for (int i = 0; i < count; i++) {
+      boxes[i] = aabb_with_slack(geometry[spaces[i]].min, geometry[spaces[i]].max);
+    }
+    AabbGrid grid = build_aabb_grid(boxes, count);
+    OverlapReportContext context = { { geometry, spaces, rects, separated }, levels->min_level + l, report };
+    aabb_grid_pairs(&grid, boxes, report_level_collisions, &context);
+    free_aabb_grid(grid);
+  }
+  // the grid hands the pairs out cell by cell; sort them so the report reads in lot order
+  qsort(report->issues + first_issue, report->issue_count - first_issue, sizeof(ValidationIssue), compare_space_issues);
+  if (levels != lot.levels) free_level_table(levels);
+  free(boxes);
+  free(rects);
+  free(separated);
+}
+
+// a space index with its name, so spaces can be sorted by name
+typedef struct {
+  const char *name;
+  int index;
+} NameKey;
+
+// orders by name, keeping the lot order within a name
+static int compare_name_keys(const void *a, const void *b) {
+  const NameKey *x = a, *y = b;
+  int order = strcmp(x->name, y->name);
+  if (order != 0) return order;
+  return (x->index > y->index) - (x->index < y->index);
+}
+
+// report every space that reuses the name of an earlier space, together with that earlier space
+static void report_duplicate_names(const Lot lot, ValidationReport *report) {
+  NameKey *keys = malloc(sizeof(NameKey) * (lot.space_count + 1));
+  for (int i = 0; i < lot.space_count; i++) keys[i] = (NameKey){ lot.spaces[i].name, i };
+  qsort(keys, lot.space_count, sizeof(NameKey), compare_name_keys);
+  int first_issue = report->issue_count;
+  for (int first = 0, i = 1; i < lot.space_count; i++) {
+    if (strcmp(keys[i].name, keys[first].name) != 0) {
+      first = i;
+      continue;
+    }
+    report_issue(report, DuplicateSpaceNames, keys[i].index, keys[first].index, -1, lot.spaces[keys[i].index].location.level);
+  }
+  qsort(report->issues + first_issue, report->issue_count - first_issue, sizeof(ValidationIssue), compare_space_issues);
+  free(keys);
+}
+
+// check every rule and collect everything that breaks them
+// lots built by hand get their geometry and corridor indexes computed just for this
+ValidationReport validate_lot_report(const Lot lot) {
+  ValidationReport report = { NULL, 0, 0 };
+  SpaceGeometry *geometry = lot.geometry ? lot.geometry : build_space_geometry(lot);
+  const CorridorIndex *clearance = lot_corridor_index(lot, path_clearance);
+  CorridorIndex *built_clearance = clearance ? NULL : build_corridor_index(lot, path_clearance);
+  if (built_clearance) clearance = built_clearance;
+  const CorridorIndex *access = lot_corridor_index(lot, path_accessibility);
+  CorridorIndex *built_access = access ? NULL : build_corridor_index(lot, path_accessibility);
+  if (built_access) access = built_access;
+
+  // Rule 0: every path with no length
+  for (int i = 0; i < lot.path_count; i++) {
+    if (vector_length(lot.paths[i].vector) < DBL_EPSILON) {
+      report_issue(&report, ZeroLengthPath, -1, -1, i, lot.paths[i].start_point.level);
+    }
+  }
+
+  // Rule 1: every orphan path, then every up and down no path meets
+  EndpointIndex endpoints = build_endpoint_index(lot);
+  for (int i = 0; i < lot.path_count; i++) {
+    if (!path_start_connected(lot, &endpoints, i)) {
+      report_issue(&report, PathNotConnected, -1, -1, i, lot.paths[i].start_point.level);
+    }
+  }
+  for (int m = 0; m < lot.up_count; m++) {
+    if (!location_meets_path(&endpoints, lot.ups[m])) report_issue(&report, PathNotConnected, -1, -1, -1, lot.ups[m].level);
+  }
+  for (int o = 0; o < lot.down_count; o++) {
+    if (!location_meets_path(&endpoints, lot.downs[o])) report_issue(&report, PathNotConnected, -1, -1, -1, lot.downs[o].level);
+  }
+  free_endpoint_index(endpoints);
+
+  // Rule 2: every pair of overlapping spaces
+  report_overlaps(lot, geometry, &report);
+
+  // Rule 3: every space and path it encroaches on
+  int *paths = malloc(sizeof(int) * (lot.path_count + 1));
+  for (int i = 0; i < lot.space_count; i++) {
+    int level = lot.spaces[i].location.level;
+    int count = corridors_touching_space(clearance, &geometry[i], level, paths);
+    for (int k = 0; k < count; k++) {
+      report_issue(&report, SpacesEncroachPath, i, -1, paths[k], level);
+    }
+  }
+  free(paths);
+
+  // Rule 4: every space no path reaches
+  for (int i = 0; i < lot.space_count; i++) {
+    int level = lot.spaces[i].location.level;
+    if (corridors_touching_space(access, &geometry[i], level, NULL) == 0) {
+      report_issue(&report, SpacesInaccessible, i, -1, -1, level);
+    }
+  }
+
+  // Rule 5: the entrance and the POI, each on its own
+  if (lot.entrance.level < 0 || lot.entrance.level >= lot.level_count) {
+    report_issue(&report, InvalidEntranceOrPOI, -1, -1, -1, lot.entrance.level);
+  }
+  if (lot.POI.level < 0 || lot.POI.level >= lot.level_count) {
+    report_issue(&report, InvalidEntranceOrPOI, -1, -1, -1, lot.POI.level);
+  }
+
+  // Rule 6: every space whose name was already taken
+  report_duplicate_names(lot, &report);
+
+  // Rule 7: this one is about the whole lot
+  if (!has_correct_up_down_count(lot)) {
+    report_issue(&report, IncorrectUpDownCount, -1, -1, -1, -1);
+  }
+
+  // Rule 8: every level missing its up or its down (or both)
+  if (lot.level_count > 1) {
+    int *has_up = calloc(lot.level_count, sizeof(int));
+    int *has_down = calloc(lot.level_count, sizeof(int));
+    for (int i = 0; i < lot.up_count; i++) {
+      if (lot.ups[i].level >= 0 && lot.ups[i].level < lot.level_count) has_up[lot.ups[i].level] = 1;
+    }
+    for (int i = 0; i < lot.down_count; i++) {
+      if (lot.downs[i].level >= 0 && lot.downs[i].level < lot.level_count) has_down[lot.downs[i].level] = 1;
+    }
+    // every level except the top needs an up, and every level except the bottom needs a down
+    for (int l = 0; l < lot.level_count; l++) {
+      if ((l < lot.level_count - 1 && !has_up[l]) || (l > 0 && !has_down[l])) {
+        report_issue(&report, LevelsMissingUpsOrDowns, -1, -1, -1, l);
+      }
+    }
+    free(has_up);
+    free(has_down);
+  }
+
+  // Rule 9: every name that is too long
+  for (int i = 0; i < lot.space_count; i++) {
+    if (strlen(lot.spaces[i].name) > 10) {
+      report_issue(&report, SpaceNameTooLong, i, -1, -1, lot.spaces[i].location.level);
+    }
+  }
+
+  if (geometry != lot.geometry) free(geometry);
+  free_corridor_index(built_clearance);
+  free_corridor_index(built_access);
+  return report;
+}
+
+// the result validate_lot gives for the same lot: the error of the first issue, if there is one
+ValidationResult validation_report_result(const ValidationReport report) {
+  if (report.issue_count == 0) return OK;
+  return ERR(report.issues[0].error);
+}
+
+void free_validation_report(ValidationReport report) {
+  free(report.issues);
+}
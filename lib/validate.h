@@ -1,5 +1,7 @@
 #pragma once
 #include <data.h>
+#include <spatial.h>
+#include <threadPool.h>
 
 typedef enum {
   Ok,
@@ -25,14 +27,58 @@ typedef struct {
   LotValidationError error;
 } ValidationResult;
 
+// one thing that breaks a rule; the fields that do not apply to its rule are -1
+typedef struct {
+  LotValidationError error;
+  int space;       // index into lot.spaces
+  int other_space; // the space it overlaps or shares its name with
+  int path;        // index into lot.paths
+  int level;
+} ValidationIssue;
+
+// everything wrong with a lot, in the order validate_lot checks the rules
+typedef struct {
+  ValidationIssue *issues;
+  int issue_count;
+  int capacity;
+} ValidationReport;
+
+// number of rules validate_lot checks, see validate.c
+#define VALIDATION_RULE_COUNT 10
+
+// how long each rule took, in wall clock milliseconds
+typedef struct {
+  double rule_ms[VALIDATION_RULE_COUNT];
+  double total_ms;
+} ValidationTiming;
+
+// the corridor of every path at one margin, with a bounding volume hierarchy per level
+// so a space only gets tested against the corridors near it
+struct CorridorIndex {
+  double margin;
+  Rectangle *corridors; // corridor of each path, see get_path_corridor
+  Aabb *boxes;          // bounding box of each corridor
+  int min_level;
+  int level_span;
+  AabbTree *trees;      // tree over the paths on level min_level + l
+};
+
 const char* validation_error_message(LotValidationError error);
 ValidationResult validate_lot(const Lot lot);
+ValidationResult validate_lot_parallel(const Lot lot, ThreadPool* pool, ValidationTiming* out_timing);
+ValidationReport validate_lot_report(const Lot lot);
+ValidationResult validation_report_result(const ValidationReport report);
+void free_validation_report(ValidationReport report);
 int paths_connected(const Lot lot);
 Location* get_all_endpoints(Path* paths, int path_count);
 int spaces_overlap(const Lot lot);
 int spaces_encroach_path(const Lot lot, double margin);
 Rectangle get_path_corridor(const Path path, double margin);
 int spaces_accessible(const Lot lot, double max_distance);
+CorridorIndex* build_corridor_index(const Lot lot, double margin);
+void free_corridor_index(CorridorIndex* index);
+const CorridorIndex* lot_corridor_index(const Lot lot, double margin);
+int corridors_touching_space(const CorridorIndex* index, const SpaceGeometry* space, int level, int* out_paths);
 int has_valid_entrance_and_poi(const Lot lot);
 int spaces_have_unique_names(const Lot lot);
 int has_correct_up_down_count(const Lot lot);
@@ -0,0 +1,49 @@
+#include "lotBinary.h"
+#include "lotReader.h"
+#include "lot.h"
+#include "spatial.h"
+#include "validate.h"
+#include <stdio.h>
+
+// compiles a .lot file into a .lotb file that main can map without parsing or validating
+// usage: lot_compile <parkinglot.lot> <parkinglot.lotb>
+int main(int argc, char **argv) {
+  if (argc != 3) {
+    printf("Usage: %s <lot file> <compiled lot file>\n", argv[0]);
+    return 1;
+  }
+
+  Lot lot = lot_from_file(argv[1]);
+  ThreadPool *pool = create_thread_pool(0);
+  ValidationTiming timing;
+  ValidationResult result = validate_lot_parallel(lot, pool, &timing);
+  printf("Validated in %.3f ms on %d threads:\n", timing.total_ms, thread_pool_size(pool));
+  free_thread_pool(pool);
+  for (int rule = 0; rule < VALIDATION_RULE_COUNT; rule++) {
+    printf("  rule %d: %.3f ms\n", rule, timing.rule_ms[rule]);
+  }
+  AabbStats stats = aabb_stats();
+  printf("Bounding boxes rejected %lld of %lld rectangle pairs before SAT.\n", stats.misses, stats.hits + stats.misses);
+  if (result.error != NoError) {
+    // still compiled, main refuses it the same way it refuses the text file
+    printf("Warning: lot validation failed with error: %s\n", validation_error_message(result.error));
+    // list everything at once, so the lot can be fixed in one go
+    ValidationReport report = validate_lot_report(lot);
+    for (int i = 0; i < report.issue_count; i++) {
+      ValidationIssue issue = report.issues[i];
+      printf("  %s (level %d", validation_error_message(issue.error), issue.level);
+      if (issue.space != -1) printf(", space %s", lot.spaces[issue.space].name);
+      if (issue.other_space != -1) printf(" and space %s", lot.spaces[issue.other_space].name);
+      if (issue.path != -1) printf(", path %d", issue.path);
+      printf(")\n");
+    }
+    free_validation_report(report);
+  }
+
+  int failed = lot_to_binary(lot, result, argv[1], argv[2]);
+  if (!failed) {
+    printf("Compiled %d spaces and %d paths into %s.\n", lot.space_count, lot.path_count, argv[2]);
+  }
+  free_lot(lot);
+  return failed;
+}
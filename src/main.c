@@ -3,12 +3,16 @@
 #include "display.h"
 #include "image.h"
 #include "lot.h"
+#include "lotBinary.h"
 #include "lotReader.h"
 #include "nav.h"
 #include "stdlib.h"
 #include "validate.h"
 #include <stdio.h>
 
+// how many bytes of level images may be in memory at once when every level is rendered
+static const size_t level_image_budget = (size_t)512 * 1024 * 1024;
+
 // sleeps for the given number of milliseconds
 // platform independent for puny windows users
 void sleep_ms(unsigned int milliseconds) {
@@ -26,24 +30,43 @@ void sleep_ms(unsigned int milliseconds) {
 
 int main() {
   // read lot from file
+  // a compiled lot (see lot_compile) is mapped instead if there is one; it is already validated
   char *LotFileName = "parkinglot.lot";
-  Lot lot = lot_from_file(LotFileName);
+  char *LotBinaryFileName = "parkinglot.lotb";
+  Lot lot;
+  ValidationResult result;
+  if (lot_from_binary(LotBinaryFileName, LotFileName, &lot, &result) != 0) {
+    lot = lot_from_file(LotFileName);
 
-  // Validate lot
-  ValidationResult result = validate_lot(lot);
+    // Validate lot
+    result = validate_lot(lot);
+  }
   if (result.error != NoError) {
     printf("Lot validation failed with error: %s\n",
            validation_error_message(result.error));
-    lot_to_ppm_all_levels(lot, "invalid_lot", 30, NULL, 0);
+    // every level is drawn so the problem can be found; big garages get their levels rendered side by side
+    ThreadPool *levelPool = create_thread_pool(0);
+    lot_to_ppm_all_levels_parallel(lot, "invalid_lot", 30, NULL, 0, levelPool, level_image_budget);
+    free_thread_pool(levelPool);
     return 1;
   }
 
   // Create plateDB and read it from file
+  // a compiled PlateDB (see platedb_compile) is used instead if there is one
   char *PlateDBFileName = "test/test.txt";
-  int lines = GetFileLines(PlateDBFileName);
-  Car *CarArr = (Car *)malloc(sizeof(Car) * lines);
+  char *PlateDBBinaryFileName = "test/test.plb";
+  MappedPlateDB mappedDB;
+  int useMappedDB = OpenPlateDBBinary(PlateDBBinaryFileName, PlateDBFileName, &mappedDB) == 0;
+  int lines = 0;
+  Car *CarArr = NULL;
+  PlateIndex plateIndex = {0};
+  if (!useMappedDB) {
+    CarArr = LoadPlateDB(PlateDBFileName, &lines);
+    plateIndex = BuildPlateIndex(CarArr, lines);
+  }
 
-  ReadFile(CarArr, lines, PlateDBFileName);
+  // the navigation image is rendered tile by tile on this pool, so it is ready right after check-in
+  ThreadPool *renderPool = create_thread_pool(0);
 
   while (1) {
 
@@ -69,12 +92,13 @@ int main() {
       printf("Plate is not valid. Please try again with a valid plate.\n");
       continue;
     }
-    int CarIndex = GetCarIndexFromPlate(CarArr, lines, TempPlate);
+    int CarIndex = useMappedDB ? GetCarIndexFromMappedPlateDB(&mappedDB, TempPlate)
+                               : GetCarIndexFromPlateIndex(&plateIndex, TempPlate);
     if (CarIndex == -1) {
       printf("Car with plate %s not found in database.\n", TempPlate);
       continue;
     }
-    Car car = CarArr[CarIndex];
+    Car car = useMappedDB ? GetCarFromMappedPlateDB(&mappedDB, CarIndex) : CarArr[CarIndex];
     printf("Car with plate %s found in database.\n", car.plate);
 
     // Check the car in/out
@@ -104,12 +128,18 @@ int main() {
       printf("No navigation path found to space %s.\n", foundSpace->name);
       continue;
     }
-    lot_to_ppm(lot, "outImg.ppm", foundSpace->location.level, 30, superpath, length);
+    lot_to_ppm_parallel(lot, "outImg.ppm", foundSpace->location.level, 30, superpath, length, renderPool);
     printf(
         "Navigation path to space %s generated and saved as outImg.ppm.\n",
         foundSpace->name);
   }
-  free(CarArr);
+  free_thread_pool(renderPool);
+  if (useMappedDB) {
+    ClosePlateDBBinary(mappedDB);
+  } else {
+    FreePlateIndex(plateIndex);
+    free(CarArr);
+  }
   free_lot(lot);
   return 0;
 }
@@ -0,0 +1,24 @@
+#include "PlateDB.h"
+#include <stdio.h>
+
+// compiles a text PlateDB into the binary format that main can map instantly
+// usage: platedb_compile <plates.txt> <plates.plb>
+int main(int argc, char **argv) {
+  if (argc != 3) {
+    printf("Usage: %s <text PlateDB> <binary PlateDB>\n", argv[0]);
+    return 1;
+  }
+  if (ConvertPlateDB(argv[1], argv[2])) {
+    return 1;
+  }
+
+  // check the result by mapping it again
+  MappedPlateDB db;
+  if (OpenPlateDBBinary(argv[2], argv[1], &db)) {
+    printf("ERROR: %s was written but could not be read back!\n", argv[2]);
+    return 1;
+  }
+  printf("Compiled %d plates into %s.\n", db.CarCount, argv[2]);
+  ClosePlateDBBinary(db);
+  return 0;
+}
@@ -1,4 +1,6 @@
 #include "PlateDB.h"
+#include "stdio.h"
+#include "stdlib.h"
 #include "string.h"
 #include "unity.h"
 
@@ -48,11 +50,213 @@ void test_get_plate_from_index(void) {
                                 "Checking third plate");
 }
 
+void test_load_plate_db(void) {
+  int lines = 0;
+  Car *CarArr = LoadPlateDB(FileName, &lines);
+  TEST_ASSERT_EQUAL_INT_MESSAGE(GetFileLines(FileName), lines,
+                                "Checking amount of cars loaded");
+
+  // sized from the file, so adding plates to it cannot overflow the stack
+  Car *Expected = malloc(sizeof(Car) * lines);
+  ReadFile(Expected, lines, FileName);
+  for (int i = 0; i < lines; i++) {
+    TEST_ASSERT_EQUAL_STRING_MESSAGE(Expected[i].plate, CarArr[i].plate,
+                                     "Checking plate against ReadFile");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(Expected[i].type, CarArr[i].type,
+                                  "Checking car type against ReadFile");
+  }
+  free(Expected);
+  free(CarArr);
+}
+
+void test_pack_plate(void) {
+  TEST_ASSERT_TRUE_MESSAGE(PackPlate("AB12345") == PackPlate("AB12345"), "Same plate should pack the same");
+  TEST_ASSERT_TRUE_MESSAGE(PackPlate("AB12345") != PackPlate("AB12346"), "Different plates should pack differently");
+  TEST_ASSERT_TRUE_MESSAGE(PackPlate("AB12345") != PackPlate("ab12345"), "Packing should be case sensitive like strcmp");
+  TEST_ASSERT_TRUE_MESSAGE(PackPlate("") == 0, "Empty plate should pack to 0");
+}
+
+void test_get_car_index_from_plate_index(void) {
+  int lines = 4;
+  Car CarArr[4] = {{"AB12345", 0}, {"EZ69420", 1}, {"NO99999", 2}, {"AB12345", 3}};
+  PlateIndex index = BuildPlateIndex(CarArr, lines);
+  TEST_ASSERT_EQUAL_INT_MESSAGE(0, GetCarIndexFromPlateIndex(&index, "AB12345"),
+                                "Checking first plate (duplicates keep the first)");
+  TEST_ASSERT_EQUAL_INT_MESSAGE(1, GetCarIndexFromPlateIndex(&index, "EZ69420"),
+                                "Checking second plate");
+  TEST_ASSERT_EQUAL_INT_MESSAGE(2, GetCarIndexFromPlateIndex(&index, "NO99999"),
+                                "Checking third plate");
+  TEST_ASSERT_EQUAL_INT_MESSAGE(-1, GetCarIndexFromPlateIndex(&index, "XX00000"),
+                                "Checking missing plate");
+  FreePlateIndex(index);
+}
+
+void test_plate_index_matches_linear_search(void) {
+  int lines = GetFileLines(FileName);
+  Car *CarArr = malloc(sizeof(Car) * lines);
+  ReadFile(CarArr, lines, FileName);
+  PlateIndex index = BuildPlateIndex(CarArr, lines);
+  for (int i = 0; i < lines; i++) {
+    TEST_ASSERT_EQUAL_INT_MESSAGE(GetCarIndexFromPlate(CarArr, lines, CarArr[i].plate),
+                                  GetCarIndexFromPlateIndex(&index, CarArr[i].plate),
+                                  "Index should agree with the linear search");
+  }
+  FreePlateIndex(index);
+  free(CarArr);
+}
+
+void test_mapped_plate_db(void) {
+  char *BinaryFileName = "test_platedb.plb";
+  TEST_ASSERT_EQUAL_INT_MESSAGE(0, ConvertPlateDB(FileName, BinaryFileName),
+                                "Checking conversion to binary");
+
+  MappedPlateDB db;
+  TEST_ASSERT_EQUAL_INT_MESSAGE(0, OpenPlateDBBinary(BinaryFileName, NULL, &db),
+                                "Checking the binary PlateDB can be mapped");
+
+  int lines = GetFileLines(FileName);
+  Car *CarArr = malloc(sizeof(Car) * lines);
+  ReadFile(CarArr, lines, FileName);
+  TEST_ASSERT_EQUAL_INT_MESSAGE(lines, db.CarCount, "Checking amount of cars");
+  for (int i = 0; i < lines; i++) {
+    TEST_ASSERT_EQUAL_INT_MESSAGE(GetCarIndexFromPlate(CarArr, lines, CarArr[i].plate),
+                                  GetCarIndexFromMappedPlateDB(&db, CarArr[i].plate),
+                                  "Mapped lookup should agree with the linear search");
+    Car car = GetCarFromMappedPlateDB(&db, i);
+    TEST_ASSERT_EQUAL_STRING_MESSAGE(CarArr[i].plate, car.plate, "Checking unpacked plate");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(CarArr[i].type, car.type, "Checking unpacked type");
+  }
+  TEST_ASSERT_EQUAL_INT_MESSAGE(-1, GetCarIndexFromMappedPlateDB(&db, "XX00000"),
+                                "Checking missing plate");
+
+  ClosePlateDBBinary(db);
+  free(CarArr);
+  remove(BinaryFileName);
+}
+
+void test_mapped_plate_db_rejects_text(void) {
+  MappedPlateDB db;
+  TEST_ASSERT_EQUAL_INT_MESSAGE(1, OpenPlateDBBinary(FileName, NULL, &db),
+                                "A text PlateDB is not a binary PlateDB");
+  TEST_ASSERT_EQUAL_INT_MESSAGE(1, OpenPlateDBBinary("does_not_exist.plb", NULL, &db),
+                                "Missing files should fail to open");
+}
+
+// changes one slot of the index in a compiled PlateDB held in memory
+// slot_key and slot_index are the new key and index of the slot, or keep the old ones if NULL
+static void CorruptSlot(unsigned char *data, int slot, const uint64_t *slot_key, const int32_t *slot_index) {
+  PlateDBHeader header;
+  memcpy(&header, data, sizeof(header));
+  size_t SlotKeysOffset = sizeof(PlateDBHeader) + sizeof(uint64_t) * header.CarCount + ((header.CarCount + 7) & ~7u);
+  size_t SlotIndicesOffset = SlotKeysOffset + sizeof(uint64_t) * header.SlotCount;
+  if (slot_key) memcpy(data + SlotKeysOffset + sizeof(uint64_t) * slot, slot_key, sizeof(uint64_t));
+  if (slot_index) memcpy(data + SlotIndicesOffset + sizeof(int32_t) * slot, slot_index, sizeof(int32_t));
+}
+
+static void WriteBytes(const unsigned char *data, size_t size, char *FileName) {
+  FILE *fptr = fopen(FileName, "wb");
+  fwrite(data, 1, size, fptr);
+  fclose(fptr);
+}
+
+// the index is only checked by the lookups, so a broken slot has to come back as not found
+void test_mapped_plate_db_ignores_bad_index(void) {
+  char *BinaryFileName = "test_platedb_small.plb";
+  char *CorruptFileName = "test_platedb_corrupt.plb";
+  Car CarArr[3] = {{"AB12345", 0}, {"EZ69420", 1}, {"NO99999", 2}};
+  TEST_ASSERT_EQUAL_INT(0, WritePlateDBBinary(CarArr, 3, NULL, BinaryFileName));
+
+  // the file as it was written, and which of its slots are used
+  MappedPlateDB db;
+  TEST_ASSERT_EQUAL_INT_MESSAGE(0, OpenPlateDBBinary(BinaryFileName, NULL, &db), "The written PlateDB should open");
+  int SlotCount = db.Index.SlotCount;
+  int *Used = malloc(sizeof(int) * SlotCount);
+  int first = -1;
+  for (int slot = 0; slot < SlotCount; slot++) {
+    Used[slot] = db.Index.Keys[slot] != 0;
+    if (Used[slot] && first == -1) first = slot;
+  }
+  TEST_ASSERT_TRUE(first != -1);
+  int FirstCar = db.Index.Indices[first];
+  size_t size = db.MapSize;
+  unsigned char *data = malloc(size);
+  unsigned char *copy = malloc(size);
+  memcpy(data, db.Map, size);
+  ClosePlateDBBinary(db);
+
+  int32_t BadIndices[3] = { 3, -7, (FirstCar + 1) % 3 }; // past the cars, negative and another plate's car
+  for (int i = 0; i < 3; i++) {
+    memcpy(copy, data, size);
+    CorruptSlot(copy, first, NULL, &BadIndices[i]);
+    WriteBytes(copy, size, CorruptFileName);
+    TEST_ASSERT_EQUAL_INT(0, OpenPlateDBBinary(CorruptFileName, NULL, &db));
+    TEST_ASSERT_EQUAL_INT_MESSAGE(-1, GetCarIndexFromMappedPlateDB(&db, CarArr[FirstCar].plate),
+                                  "A broken slot should give not found instead of the wrong car");
+    for (int car = 0; car < 3; car++) {
+      if (car != FirstCar) {
+        TEST_ASSERT_EQUAL_INT_MESSAGE(car, GetCarIndexFromMappedPlateDB(&db, CarArr[car].plate), "The other plates should still be found");
+      }
+    }
+    ClosePlateDBBinary(db);
+  }
+
+  // no empty slot left, so only giving up after every slot stops a missing plate from looping forever
+  memcpy(copy, data, size);
+  uint64_t Filler = PackPlate("ZZ00000");
+  for (int slot = 0; slot < SlotCount; slot++) {
+    if (!Used[slot]) CorruptSlot(copy, slot, &Filler, NULL);
+  }
+  WriteBytes(copy, size, CorruptFileName);
+  TEST_ASSERT_EQUAL_INT(0, OpenPlateDBBinary(CorruptFileName, NULL, &db));
+  TEST_ASSERT_EQUAL_INT_MESSAGE(-1, GetCarIndexFromMappedPlateDB(&db, "XX00000"), "A missing plate in a full index should not be found");
+  TEST_ASSERT_EQUAL_INT_MESSAGE(-1, GetCarIndexFromMappedPlateDB(&db, "ZZ00000"), "A slot without a car should not be found");
+  TEST_ASSERT_EQUAL_INT(1, GetCarIndexFromMappedPlateDB(&db, "EZ69420"));
+  ClosePlateDBBinary(db);
+
+  free(Used);
+  free(data);
+  free(copy);
+  remove(BinaryFileName);
+  remove(CorruptFileName);
+}
+
+void test_mapped_plate_db_rejects_changed_source(void) {
+  char *SourceFileName = "test_platedb_source.txt";
+  char *BinaryFileName = "test_platedb_source.plb";
+  FILE *source = fopen(SourceFileName, "w");
+  fputs("AB12345 0\nEZ69420 1\n", source);
+  fclose(source);
+  TEST_ASSERT_EQUAL_INT(0, ConvertPlateDB(SourceFileName, BinaryFileName));
+
+  MappedPlateDB db;
+  TEST_ASSERT_EQUAL_INT_MESSAGE(0, OpenPlateDBBinary(BinaryFileName, SourceFileName, &db), "An untouched text file should use the compiled PlateDB");
+  ClosePlateDBBinary(db);
+  TEST_ASSERT_EQUAL_INT_MESSAGE(0, OpenPlateDBBinary(BinaryFileName, "does_not_exist.txt", &db), "Without a text file there is nothing to be out of date with");
+  ClosePlateDBBinary(db);
+
+  // a plate added after compiling
+  source = fopen(SourceFileName, "a");
+  fputs("NO99999 2\n", source);
+  fclose(source);
+  TEST_ASSERT_EQUAL_INT_MESSAGE(1, OpenPlateDBBinary(BinaryFileName, SourceFileName, &db), "A changed text file should refuse the compiled PlateDB");
+
+  remove(SourceFileName);
+  remove(BinaryFileName);
+}
+
 int main(void) {
   UNITY_BEGIN();
   RUN_TEST(test_read_file_lines);
   RUN_TEST(test_read_line);
   RUN_TEST(test_read_file_to_struct);
   RUN_TEST(test_get_plate_from_index);
+  RUN_TEST(test_load_plate_db);
+  RUN_TEST(test_pack_plate);
+  RUN_TEST(test_get_car_index_from_plate_index);
+  RUN_TEST(test_plate_index_matches_linear_search);
+  RUN_TEST(test_mapped_plate_db);
+  RUN_TEST(test_mapped_plate_db_rejects_text);
+  RUN_TEST(test_mapped_plate_db_ignores_bad_index);
+  RUN_TEST(test_mapped_plate_db_rejects_changed_source);
   return UNITY_END();
 }
@@ -48,9 +48,55 @@ void test_get_space_rectangle(void) {
   }
 }
 
+void test_get_space_geometry(void) {
+  Space test_space = {
+    .type = Standard,
+    .location = {10.0, 5.0, 0},
+    .rotation = 45.0,
+    .name = "Test Space"
+  };
+
+  SpaceGeometry geometry = get_space_geometry(test_space);
+  Rectangle rect = get_space_rectangle(test_space);
+  TEST_ASSERT_EQUAL_MEMORY_MESSAGE(&rect, &geometry.rect, sizeof(Rectangle), "geometry should hold exactly the space rectangle");
+
+  double delta = 1e-2;
+  // bounding box of the corners from test_get_space_rectangle
+  TEST_ASSERT_FLOAT_WITHIN_MESSAGE(delta, 6.46, geometry.min.x, "bounding box min x should be the leftmost corner");
+  TEST_ASSERT_FLOAT_WITHIN_MESSAGE(delta, 5.00, geometry.min.y, "bounding box min y should be the lowest corner");
+  TEST_ASSERT_FLOAT_WITHIN_MESSAGE(delta, 11.77, geometry.max.x, "bounding box max x should be the rightmost corner");
+  TEST_ASSERT_FLOAT_WITHIN_MESSAGE(delta, 10.30, geometry.max.y, "bounding box max y should be the highest corner");
+  // the entry is halfway between corner 0 and corner 1
+  TEST_ASSERT_FLOAT_WITHIN_MESSAGE(delta, 10.88, geometry.entry.x, "entry x should be the middle of the entry side");
+  TEST_ASSERT_FLOAT_WITHIN_MESSAGE(delta, 5.88, geometry.entry.y, "entry y should be the middle of the entry side");
+}
+
+void test_separating_axis_batch(void) {
+  // a row of spaces next to each other, some rotated, tested against one space in the middle
+  Space middle = { .type = Standard, .location = {10.0, 0.0, 0}, .rotation = 0.0, .name = "middle" };
+  Rectangle others[7];
+  for (int i = 0; i < 7; i++) {
+    Space space = { .type = Standard, .location = {5.0 + 2.0 * i, 1.0, 0}, .rotation = 30.0 * i, .name = "other" };
+    others[i] = get_space_rectangle(space);
+  }
+
+  int separated[7];
+  int overlapping = separating_axis_batch(get_space_rectangle(middle), others, 7, separated);
+  int expected_overlapping = 0;
+  for (int i = 0; i < 7; i++) {
+    int expected = separating_axis(get_space_rectangle(middle), others[i]);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(expected, separated[i], "the batch should agree with separating_axis");
+    expected_overlapping += !expected;
+  }
+  TEST_ASSERT_EQUAL_INT_MESSAGE(expected_overlapping, overlapping, "the batch should count the overlapping rectangles");
+  TEST_ASSERT_TRUE_MESSAGE(overlapping > 0 && overlapping < 7, "the row should have both overlapping and separated spaces");
+}
+
 int main(void) {
 	UNITY_BEGIN();
 	RUN_TEST(test_get_endpoint);
 	RUN_TEST(test_get_space_rectangle);
+	RUN_TEST(test_get_space_geometry);
+	RUN_TEST(test_separating_axis_batch);
 	return UNITY_END();
 }
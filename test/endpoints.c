@@ -0,0 +1,60 @@
+#include "unity.h"
+#include "endpoints.h"
+#include "lotReader.h"
+#include "lot.h"
+#include "data.h"
+
+static Lot lot;
+static EndpointIndex endpoints;
+
+void setUp() {
+  lot = lot_from_file("../../test/test.lot");
+  endpoints = build_endpoint_index(lot);
+}
+
+void tearDown() {
+  free_endpoint_index(endpoints);
+  free_lot(lot);
+}
+
+void test_build_endpoint_index(void) {
+  TEST_ASSERT_EQUAL_INT_MESSAGE(9, endpoints.endpoint_count, "every distinct location should have one endpoint");
+  TEST_ASSERT_TRUE_MESSAGE(endpoint_index_of(&endpoints, lot.entrance) >= 0, "the entrance should have an endpoint");
+  TEST_ASSERT_EQUAL_INT_MESSAGE(-1, endpoint_index_of(&endpoints, (Location){1, 2, 0}), "unknown locations have no endpoint");
+  TEST_ASSERT_EQUAL_INT_MESSAGE(-1, endpoint_index_of(&endpoints, (Location){0, 0, 7}), "the level is part of the key");
+}
+
+void test_paths_with_endpoint(void) {
+  int count = 0;
+  const int *incoming = paths_with_endpoint(&endpoints, (Location){0, 10, 0}, &count);
+  TEST_ASSERT_EQUAL_INT_MESSAGE(1, count, "one path ends at the level 0 crossing");
+  TEST_ASSERT_EQUAL_INT(0, incoming[0]);
+
+  const int *outgoing = paths_with_start_point(&endpoints, (Location){0, 10, 0}, &count);
+  TEST_ASSERT_EQUAL_INT_MESSAGE(3, count, "three paths start at the level 0 crossing");
+  TEST_ASSERT_EQUAL_INT(1, outgoing[0]);
+  TEST_ASSERT_EQUAL_INT(3, outgoing[2]);
+
+  TEST_ASSERT_NULL(paths_with_endpoint(&endpoints, (Location){1, 2, 0}, &count));
+  TEST_ASSERT_EQUAL_INT(0, count);
+}
+
+void test_ups_and_downs(void) {
+  TEST_ASSERT_TRUE(is_up_location(&endpoints, (Location){0, 20, 0}));
+  TEST_ASSERT_FALSE(is_down_location(&endpoints, (Location){0, 20, 0}));
+  TEST_ASSERT_TRUE(is_down_location(&endpoints, (Location){0, 20, 1}));
+  TEST_ASSERT_FALSE(is_up_location(&endpoints, lot.entrance));
+
+  TEST_ASSERT_EQUAL_PTR(&lot.ups[0], get_up_on_level(lot, &endpoints, 0));
+  TEST_ASSERT_EQUAL_PTR(&lot.downs[0], get_down_on_level(lot, &endpoints, 1));
+  TEST_ASSERT_NULL(get_up_on_level(lot, &endpoints, 1));
+  TEST_ASSERT_NULL(get_down_on_level(lot, &endpoints, 5));
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_build_endpoint_index);
+  RUN_TEST(test_paths_with_endpoint);
+  RUN_TEST(test_ups_and_downs);
+  return UNITY_END();
+}
@@ -0,0 +1,82 @@
+#include "unity.h"
+#include "graph.h"
+#include "lotReader.h"
+#include "lot.h"
+#include "data.h"
+#include <float.h>
+#include <stdlib.h>
+
+static Lot lot;
+
+void setUp() {
+  lot = lot_from_file("../../test/test.lot");
+}
+
+void tearDown() {
+  free_lot(lot);
+}
+
+void test_build_path_graph(void) {
+  PathGraph graph = build_path_graph(lot);
+  // 5 distinct locations on level 0 and 4 on level 1
+  TEST_ASSERT_EQUAL_INT_MESSAGE(9, graph.node_count, "every distinct location should be a single node");
+  // 7 paths plus the ramp in both directions
+  TEST_ASSERT_EQUAL_INT_MESSAGE(9, graph.edge_count, "every path and ramp direction should be an edge");
+  TEST_ASSERT_TRUE_MESSAGE(graph_node_of(graph, lot.entrance) >= 0, "the entrance should be a node");
+  TEST_ASSERT_EQUAL_INT_MESSAGE(-1, graph_node_of(graph, (Location){123, 456, 0}), "unknown locations should not be nodes");
+  free_path_graph(graph);
+}
+
+void test_shortest_paths_from_entrance(void) {
+  PathGraph graph = build_path_graph(lot);
+  double *dist = malloc(sizeof(double) * graph.node_count);
+  int *pred_edge = malloc(sizeof(int) * graph.node_count);
+  shortest_paths_from(graph, graph_node_of(graph, lot.entrance), dist, pred_edge);
+
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 0.0, dist[graph_node_of(graph, lot.entrance)]);
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 20.0, dist[graph_node_of(graph, (Location){0, 20, 0})]);
+  // up the ramp (30) and back along the level 1 path
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 50.0, dist[graph_node_of(graph, (Location){0, 20, 1})]);
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 74.0, dist[graph_node_of(graph, (Location){14, 10, 1})]);
+
+  int count = 0;
+  Path *route = graph_route_to(lot, graph, pred_edge, graph_node_of(graph, (Location){14, 10, 1}), &count);
+  TEST_ASSERT_EQUAL_INT_MESSAGE(4, count, "the ramp should not be part of the route");
+  TEST_ASSERT_NOT_NULL(route);
+  TEST_ASSERT_EQUAL_INT(0, route[0].start_point.level);
+  TEST_ASSERT_EQUAL_INT(1, route[3].start_point.level);
+
+  free(route);
+  free(dist);
+  free(pred_edge);
+  free_path_graph(graph);
+}
+
+void test_shortest_paths_unreachable(void) {
+  Lot island = create_lot(1, 2, 0, 0, 0);
+  island.entrance = (Location){0, 0, 0};
+  island.ramp_length = 30.0;
+  island.paths[0] = (Path){ .start_point = (Location){0, 0, 0}, .vector = (Vector){10, 0} };
+  island.paths[1] = (Path){ .start_point = (Location){50, 50, 0}, .vector = (Vector){10, 0} };
+
+  PathGraph graph = build_path_graph(island);
+  double *dist = malloc(sizeof(double) * graph.node_count);
+  int *pred_edge = malloc(sizeof(int) * graph.node_count);
+  shortest_paths_from(graph, graph_node_of(graph, island.entrance), dist, pred_edge);
+
+  TEST_ASSERT_TRUE_MESSAGE(dist[graph_node_of(graph, (Location){60, 50, 0})] == DBL_MAX,
+                           "a path that is not connected to the entrance should be unreachable");
+
+  free(dist);
+  free(pred_edge);
+  free_path_graph(graph);
+  free_lot(island);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_build_path_graph);
+  RUN_TEST(test_shortest_paths_from_entrance);
+  RUN_TEST(test_shortest_paths_unreachable);
+  return UNITY_END();
+}
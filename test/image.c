@@ -0,0 +1,158 @@
+#include "unity.h"
+#include "image.h"
+#include "lot.h"
+#include "lotReader.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+void setUp() {}
+
+void tearDown() {}
+
+// reads a whole file into memory
+static unsigned char *read_file(const char *filename, long *out_size) {
+  FILE *fp = fopen(filename, "rb");
+  if (!fp) return NULL;
+  fseek(fp, 0, SEEK_END);
+  long size = ftell(fp);
+  fseek(fp, 0, SEEK_SET);
+  unsigned char *data = malloc(size > 0 ? size : 1);
+  *out_size = (long)fread(data, 1, size, fp);
+  fclose(fp);
+  return data;
+}
+
+static void assert_same_file(const char *expected_filename, const char *actual_filename) {
+  long expected_size, actual_size;
+  unsigned char *expected = read_file(expected_filename, &expected_size);
+  unsigned char *actual = read_file(actual_filename, &actual_size);
+  TEST_ASSERT_NOT_NULL(expected);
+  TEST_ASSERT_NOT_NULL(actual);
+  TEST_ASSERT_EQUAL_INT(expected_size, actual_size);
+  TEST_ASSERT_EQUAL_MEMORY_MESSAGE(expected, actual, expected_size, "the tiled image should be byte for byte the same");
+  free(expected);
+  free(actual);
+}
+
+// 64 bit FNV-1a hash of a whole file, so reference images can live in the test as one number each
+static uint64_t hash_file(const char *filename) {
+  long size;
+  unsigned char *data = read_file(filename, &size);
+  TEST_ASSERT_NOT_NULL(data);
+  uint64_t h = 0xcbf29ce484222325ULL;
+  for (long i = 0; i < size; i++) {
+    h ^= data[i];
+    h *= 0x100000001b3ULL;
+  }
+  free(data);
+  return h;
+}
+
+// test.lot with the first two paths as the route, drawn by lot_to_ppm before it was split into tiles
+static const struct {
+  int pixels_per_unit;
+  int level;
+  uint64_t hash;
+} reference_images[] = {
+  { 1, 0, 0xf3902c36a8c6db90ULL },
+  { 1, 1, 0xe12612c3b6ccb6ddULL },
+  { 7, 0, 0x652a4d73806e5257ULL },
+  { 7, 1, 0x113e79b06d137a98ULL },
+  { 20, 0, 0xed8a90086451da26ULL },
+  { 20, 1, 0xbb4885aa34959e06ULL }
+};
+
+// comparing the two entry points with each other can't catch a change they share
+void test_lot_to_ppm_matches_reference() {
+  Lot lot = lot_from_file("../../test/test.lot");
+  Path nav[2] = { lot.paths[0], lot.paths[1] };
+  ThreadPool *pool = create_thread_pool(3);
+
+  for (size_t i = 0; i < sizeof(reference_images) / sizeof(reference_images[0]); i++) {
+    int level = reference_images[i].level, scale = reference_images[i].pixels_per_unit;
+    TEST_ASSERT_EQUAL_INT(0, lot_to_ppm(lot, "test_image_reference.ppm", level, scale, nav, 2));
+    TEST_ASSERT_TRUE_MESSAGE(hash_file("test_image_reference.ppm") == reference_images[i].hash, "lot_to_ppm should draw the reference image");
+    TEST_ASSERT_EQUAL_INT(0, lot_to_ppm_parallel(lot, "test_image_reference.ppm", level, scale, nav, 2, pool));
+    TEST_ASSERT_TRUE_MESSAGE(hash_file("test_image_reference.ppm") == reference_images[i].hash, "lot_to_ppm_parallel should draw the reference image");
+  }
+  remove("test_image_reference.ppm");
+
+  free_thread_pool(pool);
+  free_lot(lot);
+}
+
+// the tiles share edges with paths, spaces and labels at any scale, and none of that may show
+void test_lot_to_ppm_parallel_matches_lot_to_ppm() {
+  Lot lot = lot_from_file("../../test/test.lot");
+  Path nav[2] = { lot.paths[0], lot.paths[1] };
+  ThreadPool *pool = create_thread_pool(3);
+
+  int scales[] = { 1, 7, 20 };
+  for (int s = 0; s < 3; s++) {
+    for (int level = 0; level < lot.level_count; level++) {
+      TEST_ASSERT_EQUAL_INT(0, lot_to_ppm(lot, "test_image_serial.ppm", level, scales[s], nav, 2));
+      TEST_ASSERT_EQUAL_INT(0, lot_to_ppm_parallel(lot, "test_image_tiled.ppm", level, scales[s], nav, 2, pool));
+      assert_same_file("test_image_serial.ppm", "test_image_tiled.ppm");
+    }
+  }
+  remove("test_image_serial.ppm");
+  remove("test_image_tiled.ppm");
+
+  free_thread_pool(pool);
+  free_lot(lot);
+}
+
+// a level with nothing on it has no image either way
+void test_lot_to_ppm_parallel_empty_level() {
+  Lot lot = lot_from_file("../../test/test.lot");
+  ThreadPool *pool = create_thread_pool(2);
+  TEST_ASSERT_EQUAL_INT(-1, lot_to_ppm_parallel(lot, "test_image_empty.ppm", lot.level_count + 3, 10, NULL, 0, pool));
+  TEST_ASSERT_EQUAL_INT(-1, lot_to_ppm_parallel(lot, "test_image_empty.ppm", 0, 0, NULL, 0, pool));
+  free_thread_pool(pool);
+  free_lot(lot);
+}
+
+// levels rendered side by side give the same files, whether the budget fits them all or only one at a time
+void test_lot_to_ppm_all_levels_parallel_matches() {
+  Lot lot = lot_from_file("../../test/test.lot");
+  ThreadPool *pool = create_thread_pool(3);
+  TEST_ASSERT_EQUAL_INT(0, lot_to_ppm_all_levels(lot, "test_levels_serial", 5, NULL, 0));
+
+  size_t budgets[] = { 1, (size_t)1 << 30 };
+  for (int b = 0; b < 2; b++) {
+    TEST_ASSERT_EQUAL_INT(0, lot_to_ppm_all_levels_parallel(lot, "test_levels_parallel", 5, NULL, 0, pool, budgets[b]));
+    for (int level = 0; level < lot.level_count; level++) {
+      char serial[64], parallel[64];
+      snprintf(serial, sizeof(serial), "test_levels_serial_level%d.ppm", level);
+      snprintf(parallel, sizeof(parallel), "test_levels_parallel_level%d.ppm", level);
+      assert_same_file(serial, parallel);
+      if (b == 1) {
+        remove(serial);
+        remove(parallel);
+      }
+    }
+  }
+
+  // a level with nothing on it fails, like it does one at a time
+  lot.level_count++;
+  TEST_ASSERT_EQUAL_INT(-1, lot_to_ppm_all_levels_parallel(lot, "test_levels_parallel", 5, NULL, 0, pool, 0));
+  for (int level = 0; level < lot.level_count; level++) {
+    char parallel[64];
+    snprintf(parallel, sizeof(parallel), "test_levels_parallel_level%d.ppm", level);
+    remove(parallel);
+  }
+  lot.level_count--;
+
+  free_thread_pool(pool);
+  free_lot(lot);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_lot_to_ppm_matches_reference);
+  RUN_TEST(test_lot_to_ppm_parallel_matches_lot_to_ppm);
+  RUN_TEST(test_lot_to_ppm_parallel_empty_level);
+  RUN_TEST(test_lot_to_ppm_all_levels_parallel_matches);
+  return UNITY_END();
+}
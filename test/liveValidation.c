@@ -0,0 +1,150 @@
+#include "unity.h"
+#include "liveValidation.h"
+#include "lot.h"
+#include "lotReader.h"
+#include "validate.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+void setUp() {}
+
+void tearDown() {}
+
+// the live verdict should always be what validate_lot says about the lot as it is now
+static void assert_matches_validate_lot(const LiveValidation *live) {
+  Lot lot = live_validation_snapshot(live);
+  ValidationResult expected = validate_lot(lot);
+  ValidationResult actual = live_validation_result(live);
+  free_lot(lot);
+  if (expected.error != actual.error) {
+    char message[256];
+    snprintf(message, sizeof(message), "expected '%s' but the live validation says '%s'",
+      validation_error_message(expected.error), validation_error_message(actual.error));
+    TEST_FAIL_MESSAGE(message);
+  }
+}
+
+static Lot create_valid_lot() {
+  Lot lot = create_lot(2, 4, 4, 1, 1);
+  lot.entrance = (Location){0, 0, 0};
+  lot.POI = (Location){20, 0, 0};
+  lot.paths[0] = (Path){ .start_point = (Location){0, 0, 0}, .vector = (Vector){20, 0} };
+  lot.paths[1] = (Path){ .start_point = (Location){20, 0, 0}, .vector = (Vector){0, 20} };
+  lot.paths[2] = (Path){ .start_point = (Location){0, 0, 1}, .vector = (Vector){20, 0} };
+  lot.paths[3] = (Path){ .start_point = (Location){20, 0, 1}, .vector = (Vector){0, 20} };
+  lot.ups[0] = (Location){0, 0, 0};
+  lot.downs[0] = (Location){0, 0, 1};
+  lot.spaces[0] = (Space){ .type = Standard, .location = (Location){5, 4, 0}, .rotation = 0, .name = "A1" };
+  lot.spaces[1] = (Space){ .type = Standard, .location = (Location){10, 4, 0}, .rotation = 0, .name = "A2" };
+  lot.spaces[2] = (Space){ .type = Standard, .location = (Location){5, 4, 1}, .rotation = 0, .name = "B1" };
+  lot.spaces[3] = (Space){ .type = Standard, .location = (Location){10, 4, 1}, .rotation = 0, .name = "B2" };
+  return lot;
+}
+
+void test_live_validation_follows_spaces() {
+  Lot lot = create_valid_lot();
+  LiveValidation *live = create_live_validation(lot);
+  TEST_ASSERT_EQUAL_INT(NoError, live_validation_result(live).error);
+
+  // a temporary space right on top of A1
+  int temporary = live_add_space(live, (Space){ .type = Standard, .location = (Location){6, 4, 0}, .rotation = 0, .name = "T1" });
+  TEST_ASSERT_EQUAL_INT(4, temporary);
+  TEST_ASSERT_EQUAL_INT(SpacesOverlap, live_validation_result(live).error);
+
+  // moved onto the path it encroaches on it instead
+  TEST_ASSERT_EQUAL_INT(1, live_move_space(live, temporary, (Location){15, -1, 0}, 0));
+  TEST_ASSERT_EQUAL_INT(SpacesEncroachPath, live_validation_result(live).error);
+
+  // and next to it, it is fine
+  TEST_ASSERT_EQUAL_INT(1, live_move_space(live, temporary, (Location){15, 4, 0}, 0));
+  TEST_ASSERT_EQUAL_INT(NoError, live_validation_result(live).error);
+
+  // a second space with the same name, away from everything
+  int copy = live_add_space(live, (Space){ .type = Standard, .location = (Location){100, 100, 0}, .rotation = 0, .name = "T1" });
+  TEST_ASSERT_EQUAL_INT(SpacesInaccessible, live_validation_result(live).error);
+  TEST_ASSERT_EQUAL_INT(1, live_move_space(live, copy, (Location){15, 4, 1}, 0));
+  TEST_ASSERT_EQUAL_INT(DuplicateSpaceNames, live_validation_result(live).error);
+
+  TEST_ASSERT_EQUAL_INT(1, live_remove_space(live, temporary));
+  TEST_ASSERT_EQUAL_INT(0, live_remove_space(live, temporary));
+  TEST_ASSERT_EQUAL_INT(NoError, live_validation_result(live).error);
+  assert_matches_validate_lot(live);
+
+  free_live_validation(live);
+  free_lot(lot);
+}
+
+void test_live_validation_follows_paths() {
+  Lot lot = create_valid_lot();
+  LiveValidation *live = create_live_validation(lot);
+
+  // a path that starts nowhere
+  int stray = live_add_path(live, (Path){ .start_point = (Location){50, 50, 0}, .vector = (Vector){10, 0} });
+  TEST_ASSERT_EQUAL_INT(4, stray);
+  TEST_ASSERT_EQUAL_INT(PathNotConnected, live_validation_result(live).error);
+
+  // moved to the end of path 1 it connects, but now runs straight through A2
+  TEST_ASSERT_EQUAL_INT(1, live_move_path(live, stray, (Path){ .start_point = (Location){20, 20, 0}, .vector = (Vector){-8, -14} }));
+  TEST_ASSERT_EQUAL_INT(SpacesEncroachPath, live_validation_result(live).error);
+
+  // without path 0 the spaces on level 0 have nothing to drive in from
+  TEST_ASSERT_EQUAL_INT(1, live_remove_path(live, stray));
+  TEST_ASSERT_EQUAL_INT(1, live_remove_path(live, 0));
+  TEST_ASSERT_EQUAL_INT(0, live_move_path(live, 0, lot.paths[0]));
+  assert_matches_validate_lot(live);
+  TEST_ASSERT_EQUAL_INT(Err, live_validation_result(live).result);
+
+  TEST_ASSERT_EQUAL_INT(5, live_add_path(live, lot.paths[0]));
+  TEST_ASSERT_EQUAL_INT(NoError, live_validation_result(live).error);
+
+  // a path of no length beats everything else
+  int zero = live_add_path(live, (Path){ .start_point = (Location){0, 0, 0}, .vector = (Vector){0, 0} });
+  TEST_ASSERT_EQUAL_INT(ZeroLengthPath, live_validation_result(live).error);
+  TEST_ASSERT_EQUAL_INT(1, live_move_path(live, zero, (Path){ .start_point = (Location){0, 0, 0}, .vector = (Vector){0, -5} }));
+  TEST_ASSERT_EQUAL_INT(NoError, live_validation_result(live).error);
+
+  free_live_validation(live);
+  free_lot(lot);
+}
+
+// a long run of random changes to a real lot, checked against validate_lot after every one
+void test_live_validation_matches_validate_lot() {
+  Lot lot = lot_from_file("../../test/test.lot");
+  LiveValidation *live = create_live_validation(lot);
+  assert_matches_validate_lot(live);
+
+  char names[200][8];
+  srand(1234);
+  int space_count = lot.space_count, path_count = lot.path_count;
+  for (int step = 0; step < 200; step++) {
+    Location location = { rand() % 60 - 30, rand() % 60 - 30, rand() % lot.level_count };
+    double rotation = (rand() % 4) * 90.0;
+    switch (rand() % 6) {
+      case 0:
+        snprintf(names[step], sizeof(names[step]), "R%d", rand() % 40);
+        live_add_space(live, (Space){ .type = rand() % 4, .location = location, .rotation = rotation, .name = names[step] });
+        space_count++;
+        break;
+      case 1: live_remove_space(live, rand() % space_count); break;
+      case 2: live_move_space(live, rand() % space_count, location, rotation); break;
+      case 3:
+        live_add_path(live, (Path){ .start_point = location, .vector = (Vector){ rand() % 20 - 10, rand() % 20 - 10 } });
+        path_count++;
+        break;
+      case 4: live_remove_path(live, rand() % path_count); break;
+      default: live_move_path(live, rand() % path_count, (Path){ .start_point = location, .vector = (Vector){ rand() % 20 - 10, rand() % 20 - 10 } });
+    }
+    assert_matches_validate_lot(live);
+  }
+
+  free_live_validation(live);
+  free_lot(lot);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_live_validation_follows_spaces);
+  RUN_TEST(test_live_validation_follows_paths);
+  RUN_TEST(test_live_validation_matches_validate_lot);
+  return UNITY_END();
+}
@@ -2,6 +2,7 @@
 #include "lot.h"
 #include "lotReader.h"
 #include "data.h"
+#include <limits.h>
 
 void setUp() {}
 
@@ -59,11 +60,181 @@ void test_best_space_full_occupancy(void) {
   free_lot(lot);
 }
 
+void test_best_space_without_route_index(void) {
+  Lot lot = create_lot(1, 1, 2, 0, 0);
+  lot.entrance = (Location){0, 0, 0};
+  lot.paths[0] = (Path){ .start_point = (Location){0, 0, 0}, .vector = (Vector){20, 0} };
+  lot.spaces[0] = (Space){ .type = Standard, .location = (Location){15, 4, 0}, .rotation = 0, .name = "far", .occupied = -1 };
+  lot.spaces[1] = (Space){ .type = Standard, .location = (Location){5, 4, 0}, .rotation = 0, .name = "near", .occupied = -1 };
+
+  Space* space = best_space(lot, Standard);
+  TEST_ASSERT_NOT_NULL_MESSAGE(space, "best_space should work on a lot without a route index");
+  if (space != NULL) {
+    TEST_ASSERT_EQUAL_STRING_MESSAGE("near", space->name, "best_space should return the space closest to the entrance");
+  }
+  free_lot(lot);
+}
+
+void test_best_space_after_checkout(void) {
+  Lot lot = lot_from_file("../../test/test.lot");
+  Space* first = best_space(lot, Standard);
+  TEST_ASSERT_NOT_NULL(first);
+  occupy_space(lot, first, 0);
+
+  Space* second = best_space(lot, Standard);
+  TEST_ASSERT_NOT_NULL(second);
+  TEST_ASSERT_TRUE_MESSAGE(second != first, "an occupied space should not be handed out again");
+  occupy_space(lot, second, 1);
+
+  vacate_space(lot, first);
+  TEST_ASSERT_EQUAL_PTR_MESSAGE(first, best_space(lot, Standard), "a vacated space should be the best again");
+
+  // occupying it again and vacating twice must not queue it twice
+  occupy_space(lot, first, 0);
+  vacate_space(lot, first);
+  vacate_space(lot, first);
+  occupy_space(lot, first, 0);
+  TEST_ASSERT_TRUE_MESSAGE(best_space(lot, Standard) != first, "a space should only be queued once");
+  free_lot(lot);
+}
+
+void test_handle_checkin_in_and_out(void) {
+  Lot lot = lot_from_file("../../test/test.lot");
+  Car car = { "AB12345", Standard };
+  int car_index = 500; // larger than the initial map so it has to grow
+
+  Space* assigned = NULL;
+  TEST_ASSERT_EQUAL_INT_MESSAGE(CheckInSuccess, handle_checkin(lot, car, car_index, &assigned), "first scan should check in");
+  TEST_ASSERT_NOT_NULL(assigned);
+  TEST_ASSERT_EQUAL_INT_MESSAGE((int)(assigned - lot.spaces), get_occupied_space_from_car(lot, car_index),
+                                "the car should be found in its space");
+  TEST_ASSERT_EQUAL_INT_MESSAGE(-1, get_occupied_space_from_car(lot, 3), "other cars are not parked");
+
+  TEST_ASSERT_EQUAL_INT_MESSAGE(CheckOutSuccess, handle_checkin(lot, car, car_index, &assigned), "second scan should check out");
+  TEST_ASSERT_EQUAL_INT_MESSAGE(-1, get_occupied_space_from_car(lot, car_index), "the car should be gone after checkout");
+  TEST_ASSERT_EQUAL_INT(-1, assigned->occupied);
+  free_lot(lot);
+}
+
+void test_space_columns_follow_occupancy(void) {
+  Lot lot = lot_from_file("../../test/test.lot");
+  TEST_ASSERT_NOT_NULL_MESSAGE(lot.columns, "loaded lots should have space columns");
+  for (int i = 0; i < lot.space_count; i++) {
+    TEST_ASSERT_EQUAL_INT(lot.spaces[i].type, lot.columns->type[i]);
+    TEST_ASSERT_EQUAL_INT(lot.spaces[i].location.level, lot.columns->level[i]);
+    TEST_ASSERT_EQUAL_DOUBLE(lot.spaces[i].location.x, lot.columns->x[i]);
+    TEST_ASSERT_EQUAL_DOUBLE(lot.spaces[i].location.y, lot.columns->y[i]);
+  }
+
+  occupy_space(lot, &lot.spaces[3], 11);
+  occupy_space(lot, &lot.spaces[5], 12);
+  TEST_ASSERT_EQUAL_INT_MESSAGE(2, count_occupied_spaces(lot), "two spaces were occupied");
+  TEST_ASSERT_EQUAL_INT(11, lot.columns->occupied[3]);
+  vacate_space(lot, &lot.spaces[3]);
+  TEST_ASSERT_EQUAL_INT_MESSAGE(1, count_occupied_spaces(lot), "one space is left after vacating");
+  TEST_ASSERT_EQUAL_INT(-1, lot.columns->occupied[3]);
+  free_lot(lot);
+}
+
+void test_level_table(void) {
+  Lot lot = create_lot(3, 3, 4, 1, 1);
+  lot.paths[0] = (Path){ .start_point = (Location){0, 0, 2}, .vector = (Vector){5, 0} };
+  lot.paths[1] = (Path){ .start_point = (Location){0, 0, 0}, .vector = (Vector){5, 0} };
+  lot.paths[2] = (Path){ .start_point = (Location){0, 0, 2}, .vector = (Vector){0, 5} };
+  lot.spaces[0] = (Space){ .location = (Location){1, 1, 0} };
+  lot.spaces[1] = (Space){ .location = (Location){1, 1, 2} };
+  lot.spaces[2] = (Space){ .location = (Location){1, 1, 2} };
+  lot.spaces[3] = (Space){ .location = (Location){1, 1, 0} };
+  lot.ups[0] = (Location){0, 0, 0};
+  lot.downs[0] = (Location){0, 0, 2};
+  TEST_ASSERT_EQUAL_INT_MESSAGE(2, count_levels(lot), "level 1 has nothing on it");
+
+  lot.levels = build_level_table(lot);
+  TEST_ASSERT_EQUAL_INT(0, lot.levels->min_level);
+  TEST_ASSERT_EQUAL_INT(3, lot.levels->level_span);
+  TEST_ASSERT_EQUAL_INT(2, lot.levels->level_count);
+  const LevelSummary *ground = lot_level_summary(lot, 0);
+  TEST_ASSERT_EQUAL_INT(2, ground->space_count);
+  TEST_ASSERT_EQUAL_INT(0, ground->first_space);
+  TEST_ASSERT_EQUAL_INT(4, ground->end_space);
+  TEST_ASSERT_EQUAL_INT(1, ground->path_count);
+  TEST_ASSERT_EQUAL_INT(1, ground->first_path);
+  TEST_ASSERT_EQUAL_INT(2, ground->end_path);
+  TEST_ASSERT_EQUAL_INT(1, ground->up_count);
+  const LevelSummary *empty = lot_level_summary(lot, 1);
+  TEST_ASSERT_EQUAL_INT(0, empty->space_count + empty->path_count + empty->up_count + empty->down_count);
+  TEST_ASSERT_EQUAL_INT(empty->first_space, empty->end_space);
+  const LevelSummary *top = lot_level_summary(lot, 2);
+  TEST_ASSERT_EQUAL_INT(1, top->first_space);
+  TEST_ASSERT_EQUAL_INT(3, top->end_space);
+  TEST_ASSERT_EQUAL_INT(0, top->first_path);
+  TEST_ASSERT_EQUAL_INT(3, top->end_path);
+  TEST_ASSERT_EQUAL_INT(1, top->down_count);
+  TEST_ASSERT_NULL(lot_level_summary(lot, 3));
+  TEST_ASSERT_NULL(lot_level_summary(lot, -1));
+
+  // the buckets list each level's spaces and paths in lot order
+  int count;
+  const int *bucket = level_spaces(lot.levels, 0, &count);
+  TEST_ASSERT_EQUAL_INT(2, count);
+  TEST_ASSERT_EQUAL_INT(0, bucket[0]);
+  TEST_ASSERT_EQUAL_INT(3, bucket[1]);
+  bucket = level_paths(lot.levels, 0, &count);
+  TEST_ASSERT_EQUAL_INT(1, count);
+  TEST_ASSERT_EQUAL_INT(1, bucket[0]);
+  bucket = level_spaces(lot.levels, 2, &count);
+  TEST_ASSERT_EQUAL_INT(2, count);
+  TEST_ASSERT_EQUAL_INT(1, bucket[0]);
+  TEST_ASSERT_EQUAL_INT(2, bucket[1]);
+  bucket = level_paths(lot.levels, 2, &count);
+  TEST_ASSERT_EQUAL_INT(2, count);
+  TEST_ASSERT_EQUAL_INT(0, bucket[0]);
+  TEST_ASSERT_EQUAL_INT(2, bucket[1]);
+  level_spaces(lot.levels, 1, &count);
+  TEST_ASSERT_EQUAL_INT(0, count);
+  level_paths(lot.levels, 7, &count);
+  TEST_ASSERT_EQUAL_INT(0, count);
+  free_lot(lot);
+}
+
+// a typo'd level would make the dense level table huge, so the loaders check how far apart the levels are first
+void test_level_span_out_of_range(void) {
+  Lot lot = create_lot(2, 1, 2, 0, 1);
+  lot.paths[0] = (Path){ .start_point = (Location){0, 0, 0}, .vector = (Vector){5, 0} };
+  lot.spaces[0] = (Space){ .location = (Location){1, 1, 0} };
+  lot.spaces[1] = (Space){ .location = (Location){1, 1, 3} };
+  lot.downs[0] = (Location){0, 0, 3};
+  int min_level, max_level;
+  TEST_ASSERT_EQUAL_INT_MESSAGE(0, level_span_out_of_range(lot, &min_level, &max_level), "4 things can be spread over 4 levels");
+
+  lot.downs[0].level = 100000000;
+  TEST_ASSERT_EQUAL_INT(1, level_span_out_of_range(lot, &min_level, &max_level));
+  TEST_ASSERT_EQUAL_INT(0, min_level);
+  TEST_ASSERT_EQUAL_INT(100000000, max_level);
+
+  // below 0 is fine, only the distance counts
+  lot.downs[0].level = -3;
+  lot.spaces[1].location.level = -1;
+  TEST_ASSERT_EQUAL_INT(0, level_span_out_of_range(lot, &min_level, &max_level));
+  lot.downs[0].level = -4;
+  TEST_ASSERT_EQUAL_INT_MESSAGE(1, level_span_out_of_range(lot, &min_level, &max_level), "levels -4 to 0 are 5 levels");
+  lot.downs[0].level = INT_MIN;
+  lot.spaces[1].location.level = INT_MAX;
+  TEST_ASSERT_EQUAL_INT_MESSAGE(1, level_span_out_of_range(lot, &min_level, &max_level), "the span must not overflow");
+  free_lot(lot);
+}
+
 int main(void) {
 	UNITY_BEGIN();
 	RUN_TEST(test_create_lot);
 	RUN_TEST(test_best_space_no_occupancy);
 	RUN_TEST(test_best_space_partial_occupancy);
 	RUN_TEST(test_best_space_full_occupancy);
+	RUN_TEST(test_best_space_without_route_index);
+	RUN_TEST(test_best_space_after_checkout);
+	RUN_TEST(test_handle_checkin_in_and_out);
+	RUN_TEST(test_space_columns_follow_occupancy);
+	RUN_TEST(test_level_table);
+	RUN_TEST(test_level_span_out_of_range);
 	return UNITY_END();
 }
@@ -0,0 +1,165 @@
+#include "unity.h"
+#include "lotBinary.h"
+#include "lotReader.h"
+#include "lot.h"
+#include "nav.h"
+#include "validate.h"
+#include "data.h"
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <utime.h>
+
+static char *BinaryFileName = "test_lot.lotb";
+
+void setUp() {}
+
+void tearDown() {
+  remove(BinaryFileName);
+}
+
+void test_lot_binary_round_trip(void) {
+  Lot lot = lot_from_file("../../test/test.lot");
+  ValidationResult result = validate_lot(lot);
+  TEST_ASSERT_EQUAL_INT_MESSAGE(0, lot_to_binary(lot, result, NULL, BinaryFileName), "Writing the compiled lot should succeed");
+
+  Lot mapped;
+  ValidationResult mapped_result;
+  TEST_ASSERT_EQUAL_INT_MESSAGE(0, lot_from_binary(BinaryFileName, NULL, &mapped, &mapped_result), "Loading the compiled lot should succeed");
+  TEST_ASSERT_NOT_NULL_MESSAGE(mapped.mapping, "Compiled lot should be memory mapped");
+  TEST_ASSERT_EQUAL_INT(result.result, mapped_result.result);
+  TEST_ASSERT_EQUAL_INT(result.error, mapped_result.error);
+  TEST_ASSERT_EQUAL_INT(lot.level_count, mapped.level_count);
+  TEST_ASSERT_EQUAL_INT(lot.space_count, mapped.space_count);
+  TEST_ASSERT_EQUAL_INT(lot.path_count, mapped.path_count);
+  TEST_ASSERT_EQUAL_INT(lot.up_count, mapped.up_count);
+  TEST_ASSERT_EQUAL_INT(lot.down_count, mapped.down_count);
+  TEST_ASSERT_EQUAL_DOUBLE(lot.ramp_length, mapped.ramp_length);
+  for (int i = 0; i < lot.space_count; i++) {
+    TEST_ASSERT_EQUAL_STRING_MESSAGE(lot.spaces[i].name, mapped.spaces[i].name, "Space names should survive the round trip");
+    TEST_ASSERT_EQUAL_INT(lot.spaces[i].type, mapped.spaces[i].type);
+    TEST_ASSERT_EQUAL_DOUBLE(lot.routes->space_routes[i].cost, mapped.routes->space_routes[i].cost);
+  }
+  TEST_ASSERT_EQUAL_MEMORY(lot.paths, mapped.paths, sizeof(Path) * lot.path_count);
+
+  free_lot(lot);
+  free_lot(mapped);
+}
+
+void test_lot_binary_is_usable(void) {
+  Lot lot = lot_from_file("../../test/test.lot");
+  lot_to_binary(lot, validate_lot(lot), NULL, BinaryFileName);
+  free_lot(lot);
+
+  Lot mapped;
+  TEST_ASSERT_EQUAL_INT(0, lot_from_binary(BinaryFileName, NULL, &mapped, NULL));
+  // same answers as the text lot (see test/lot.c and test/nav.c)
+  Space *space = best_space(mapped, Standard);
+  TEST_ASSERT_NOT_NULL(space);
+  TEST_ASSERT_EQUAL_STRING_MESSAGE("D4", space->name, "best_space on a compiled lot should still pick D4");
+
+  int count = 0;
+  Path *superpath = superpath_to_space(mapped, *space_by_name(mapped, "C6"), &count);
+  TEST_ASSERT_EQUAL_INT_MESSAGE(5, count, "Superpath on a compiled lot should consist of 5 paths");
+  free(superpath);
+
+  // occupying a space only changes the private copy, never the file
+  occupy_space(mapped, space, 7);
+  TEST_ASSERT_EQUAL_INT(7, space->occupied);
+  free_lot(mapped);
+
+  TEST_ASSERT_EQUAL_INT(0, lot_from_binary(BinaryFileName, NULL, &mapped, NULL));
+  TEST_ASSERT_EQUAL_INT(-1, space_by_name(mapped, "D4")->occupied);
+  free_lot(mapped);
+}
+
+void test_lot_binary_rejects_text(void) {
+  Lot lot;
+  TEST_ASSERT_EQUAL_INT_MESSAGE(1, lot_from_binary("../../test/test.lot", NULL, &lot, NULL), "A text lot is not a compiled lot");
+  TEST_ASSERT_EQUAL_INT_MESSAGE(1, lot_from_binary("does_not_exist.lotb", NULL, &lot, NULL), "A missing file should fail to load");
+}
+
+// a compiled lot with a space type past EV is refused, like the text loader refuses it
+void test_lot_binary_rejects_bad_space_type(void) {
+  Lot lot = lot_from_file("../../test/test.lot");
+  TEST_ASSERT_EQUAL_INT(0, lot_to_binary(lot, validate_lot(lot), NULL, BinaryFileName));
+  free_lot(lot);
+
+  FILE *fptr = fopen(BinaryFileName, "r+b");
+  TEST_ASSERT_NOT_NULL(fptr);
+  LotBinaryHeader header;
+  TEST_ASSERT_EQUAL_INT(1, (int)fread(&header, sizeof(header), 1, fptr));
+  SpaceType type = (SpaceType)7;
+  fseek(fptr, (long)(header.spaces_offset + sizeof(Space) * 5 + offsetof(Space, type)), SEEK_SET);
+  fwrite(&type, sizeof(type), 1, fptr);
+  fclose(fptr);
+
+  Lot mapped;
+  TEST_ASSERT_EQUAL_INT_MESSAGE(1, lot_from_binary(BinaryFileName, NULL, &mapped, NULL), "A space type past EV should be refused");
+}
+
+// copies test.lot, so the copy can be changed after it was compiled
+static void copy_test_lot(const char *filename) {
+  FILE *in = fopen("../../test/test.lot", "rb");
+  FILE *out = fopen(filename, "wb");
+  TEST_ASSERT_NOT_NULL(in);
+  TEST_ASSERT_NOT_NULL(out);
+  char buffer[4096];
+  size_t read;
+  while ((read = fread(buffer, 1, sizeof(buffer), in)) > 0) {
+    fwrite(buffer, 1, read, out);
+  }
+  fclose(in);
+  fclose(out);
+}
+
+void test_lot_binary_rejects_changed_source(void) {
+  char *SourceFileName = "test_source.lot";
+  copy_test_lot(SourceFileName);
+  Lot lot = lot_from_file(SourceFileName);
+  TEST_ASSERT_EQUAL_INT(0, lot_to_binary(lot, validate_lot(lot), SourceFileName, BinaryFileName));
+  free_lot(lot);
+
+  Lot mapped;
+  TEST_ASSERT_EQUAL_INT_MESSAGE(0, lot_from_binary(BinaryFileName, SourceFileName, &mapped, NULL), "An untouched source should use the compiled lot");
+  free_lot(mapped);
+  TEST_ASSERT_EQUAL_INT_MESSAGE(0, lot_from_binary(BinaryFileName, "does_not_exist.lot", &mapped, NULL), "Without a source there is nothing to be out of date with");
+  free_lot(mapped);
+
+  // touched, but just as big
+  struct stat info;
+  TEST_ASSERT_EQUAL_INT(0, stat(SourceFileName, &info));
+  struct utimbuf times = { info.st_atime, info.st_mtime + 10 };
+  TEST_ASSERT_EQUAL_INT(0, utime(SourceFileName, &times));
+  TEST_ASSERT_EQUAL_INT_MESSAGE(1, lot_from_binary(BinaryFileName, SourceFileName, &mapped, NULL), "A source changed after compiling should refuse the compiled lot");
+
+  // with the old time back it is fine again, until the text changes
+  times.modtime = info.st_mtime;
+  utime(SourceFileName, &times);
+  TEST_ASSERT_EQUAL_INT(0, lot_from_binary(BinaryFileName, SourceFileName, &mapped, NULL));
+  free_lot(mapped);
+  FILE *source = fopen(SourceFileName, "ab");
+  fputs("# edited\n", source);
+  fclose(source);
+  utime(SourceFileName, &times);
+  TEST_ASSERT_EQUAL_INT_MESSAGE(1, lot_from_binary(BinaryFileName, SourceFileName, &mapped, NULL), "A source of another size should refuse the compiled lot");
+
+  // a lot compiled without a source is never taken for one
+  lot = lot_from_file(SourceFileName);
+  TEST_ASSERT_EQUAL_INT(0, lot_to_binary(lot, validate_lot(lot), NULL, BinaryFileName));
+  free_lot(lot);
+  TEST_ASSERT_EQUAL_INT(1, lot_from_binary(BinaryFileName, SourceFileName, &mapped, NULL));
+  remove(SourceFileName);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_lot_binary_round_trip);
+  RUN_TEST(test_lot_binary_is_usable);
+  RUN_TEST(test_lot_binary_rejects_text);
+  RUN_TEST(test_lot_binary_rejects_bad_space_type);
+  RUN_TEST(test_lot_binary_rejects_changed_source);
+  return UNITY_END();
+}
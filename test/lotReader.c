@@ -1,6 +1,10 @@
 #include "lotReader.h"
 #include "data.h"
+#include "lot.h"
 #include "unity.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 void setUp() {}
 
@@ -47,11 +51,167 @@ void test_readLocation() {
   TEST_ASSERT_EQUAL_INT(5, location->level);
 }
 
+// lines that stop early or miss a field are rejected instead of read half way
+void test_read_truncated_lines() {
+  const char *spaces[] = {
+    "",
+    "name=",
+    "name=A1",
+    "name=A1 type=2",
+    "name=A1 type=2 location(x=-12.0 y=2.0",
+    "name=A1 type=2 location(x=-12.0 y=2.0 level=0)",
+    "name=A1 type=2 location(x=-12.0 y=2.0 level=0) rotation=",
+    "name=A1 location(x=-12.0 y=2.0 level=0) rotation=0",
+    "name=A1 type=2 location(y=2.0 level=0) rotation=0"
+  };
+  for (int i = 0; i < (int)(sizeof(spaces) / sizeof(spaces[0])); i++) {
+    TEST_ASSERT_NULL_MESSAGE(readSpace((char *)spaces[i]), spaces[i]);
+  }
+
+  const char *paths[] = {
+    "vec(x=1.0 y=0.0)",
+    "vec(x=1.0 y=0.0) location(x=0.0 y=0.0",
+    "vec(x=1.0 y=0.0) location(x=0.0 y=0.0 level=",
+    "vec(y=0.0) location(x=0.0 y=0.0 level=0)"
+  };
+  for (int i = 0; i < (int)(sizeof(paths) / sizeof(paths[0])); i++) {
+    TEST_ASSERT_NULL_MESSAGE(readPath((char *)paths[i]), paths[i]);
+  }
+
+  TEST_ASSERT_NULL(readLocation("x=6.7 y=20.0"));
+  TEST_ASSERT_NULL(readLocation("x=6.7 level=5"));
+  TEST_ASSERT_NULL(readLocation("x= y=20.0 level=5"));
+}
+
+// names are read 10 characters at most, like the old %10s; a longer one makes the line invalid
+void test_read_long_names() {
+  Space *space = readSpace("name=ABCDEFGHIJ type=1 location(x=1.0 y=2.0 level=0) rotation=90");
+  TEST_ASSERT_NOT_NULL(space);
+  TEST_ASSERT_EQUAL_STRING("ABCDEFGHIJ", space->name);
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 90.0, space->rotation);
+  free(space->name);
+  free(space);
+
+  TEST_ASSERT_NULL(readSpace("name=ABCDEFGHIJK type=1 location(x=1.0 y=2.0 level=0) rotation=90"));
+  TEST_ASSERT_NULL(readSpace("name=ABCDEFGHIJKLMNOPQRSTUVWXYZ type=1 location(x=1.0 y=2.0 level=0) rotation=90"));
+}
+
+// the type indexes the free space queues, so only the known types are read
+void test_read_space_type_out_of_range() {
+  TEST_ASSERT_NOT_NULL(readSpace("name=A1 type=3 location(x=1.0 y=2.0 level=0) rotation=90"));
+  TEST_ASSERT_NULL(readSpace("name=A1 type=7 location(x=1.0 y=2.0 level=0) rotation=90"));
+  TEST_ASSERT_NULL(readSpace("name=A1 type=4 location(x=1.0 y=2.0 level=0) rotation=90"));
+  TEST_ASSERT_NULL(readSpace("name=A1 type=-1 location(x=1.0 y=2.0 level=0) rotation=90"));
+}
+
+// writes test.lot plus extra spaces to a new file, with the given line ending
+static void write_test_lot(const char *filename, int extra_spaces, const char *line_ending) {
+  FILE *in = fopen("../../test/test.lot", "r");
+  FILE *out = fopen(filename, "wb");
+  TEST_ASSERT_NOT_NULL(in);
+  TEST_ASSERT_NOT_NULL(out);
+  char line[256];
+  while (fgets(line, sizeof(line), in)) {
+    line[strcspn(line, "\r\n")] = '\0';
+    fprintf(out, "%s%s", line, line_ending);
+  }
+  if (extra_spaces > 0) fprintf(out, "[Spaces]%s", line_ending);
+  for (int i = 0; i < extra_spaces; i++) {
+    fprintf(out, "name=LONGNAME%02d type=%d location(x=%d.0 y=100.0 level=0) rotation=0%s", i, i % 4, 3 * i, line_ending);
+  }
+  fclose(in);
+  fclose(out);
+}
+
+// the names go into an arena that moves as it grows; every space has to end up on its own name anyway
+void test_names_survive_arena_growth() {
+  write_test_lot("test_arena.lot", 60, "\n");
+  Lot lot = lot_from_file("test_arena.lot");
+  remove("test_arena.lot");
+
+  TEST_ASSERT_EQUAL_INT(24 + 60, lot.space_count);
+  TEST_ASSERT_EQUAL_STRING("A1", lot.spaces[0].name);
+  for (int i = 0; i < 60; i++) {
+    char expected[16];
+    snprintf(expected, sizeof(expected), "LONGNAME%02d", i);
+    TEST_ASSERT_EQUAL_STRING(expected, lot.spaces[24 + i].name);
+    TEST_ASSERT_EQUAL_INT(i % 4, lot.spaces[24 + i].type);
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 3.0 * i, lot.spaces[24 + i].location.x);
+    // and every name lives in the arena of the lot
+    TEST_ASSERT_TRUE(lot.spaces[24 + i].name >= lot.names);
+  }
+  free_lot(lot);
+}
+
+// levels below ground are numbered from -1 down, and load like any other level
+void test_lot_from_file_negative_level() {
+  FILE *out = fopen("test_basement.lot", "w");
+  TEST_ASSERT_NOT_NULL(out);
+  fputs("[POI]\nx=0.0 y=0.0 level=0\n[Entrance]\nx=0.0 y=0.0 level=0\n"
+        "[Spaces]\n"
+        "name=A1 type=0 location(x=3.0 y=2.0 level=0) rotation=0\n"
+        "name=B1 type=0 location(x=3.0 y=2.0 level=-1) rotation=0\n"
+        "[Paths]\n"
+        "vec(x=10.0 y=0.0) location(x=0.0 y=0.0 level=0)\n"
+        "vec(x=10.0 y=0.0) location(x=0.0 y=0.0 level=-1)\n"
+        "[Ups]\nx=10.0 y=0.0 level=-1\n[Downs]\nx=10.0 y=0.0 level=0\n"
+        "[Ramp Length]\n20.0\n", out);
+  fclose(out);
+  Lot lot = lot_from_file("test_basement.lot");
+  remove("test_basement.lot");
+
+  TEST_ASSERT_EQUAL_INT(2, lot.level_count);
+  TEST_ASSERT_EQUAL_INT(-1, lot.levels->min_level);
+  const LevelSummary *basement = lot_level_summary(lot, -1);
+  TEST_ASSERT_NOT_NULL(basement);
+  TEST_ASSERT_EQUAL_INT(1, basement->space_count);
+  TEST_ASSERT_EQUAL_INT(1, basement->first_space);
+  TEST_ASSERT_EQUAL_INT(1, basement->path_count);
+  TEST_ASSERT_EQUAL_INT(1, basement->up_count);
+  free_lot(lot);
+}
+
+// a file saved with windows line endings reads the same as the original
+void test_lot_from_file_crlf() {
+  write_test_lot("test_crlf.lot", 3, "\r\n");
+  write_test_lot("test_lf.lot", 3, "\n");
+  Lot crlf = lot_from_file("test_crlf.lot");
+  Lot lf = lot_from_file("test_lf.lot");
+  remove("test_crlf.lot");
+  remove("test_lf.lot");
+
+  TEST_ASSERT_EQUAL_INT(lf.space_count, crlf.space_count);
+  TEST_ASSERT_EQUAL_INT(lf.path_count, crlf.path_count);
+  TEST_ASSERT_EQUAL_INT(lf.up_count, crlf.up_count);
+  TEST_ASSERT_EQUAL_INT(lf.down_count, crlf.down_count);
+  TEST_ASSERT_EQUAL_INT(lf.level_count, crlf.level_count);
+  TEST_ASSERT_EQUAL_DOUBLE(lf.ramp_length, crlf.ramp_length);
+  for (int i = 0; i < lf.space_count; i++) {
+    TEST_ASSERT_EQUAL_STRING(lf.spaces[i].name, crlf.spaces[i].name);
+    TEST_ASSERT_EQUAL_INT(lf.spaces[i].type, crlf.spaces[i].type);
+    TEST_ASSERT_EQUAL_DOUBLE(lf.spaces[i].location.x, crlf.spaces[i].location.x);
+    TEST_ASSERT_EQUAL_DOUBLE(lf.spaces[i].rotation, crlf.spaces[i].rotation);
+  }
+  for (int i = 0; i < lf.path_count; i++) {
+    TEST_ASSERT_EQUAL_DOUBLE(lf.paths[i].vector.x, crlf.paths[i].vector.x);
+    TEST_ASSERT_EQUAL_DOUBLE(lf.paths[i].vector.y, crlf.paths[i].vector.y);
+    TEST_ASSERT_EQUAL_INT(lf.paths[i].start_point.level, crlf.paths[i].start_point.level);
+  }
+  free_lot(crlf);
+  free_lot(lf);
+}
+
 int main(void) {
   UNITY_BEGIN();
   RUN_TEST(test_lot_from_file);
   RUN_TEST(test_readSpace);
   RUN_TEST(test_readPath);
   RUN_TEST(test_readLocation);
+  RUN_TEST(test_read_truncated_lines);
+  RUN_TEST(test_read_long_names);
+  RUN_TEST(test_read_space_type_out_of_range);
+  RUN_TEST(test_names_survive_arena_growth);
+  RUN_TEST(test_lot_from_file_negative_level);
+  RUN_TEST(test_lot_from_file_crlf);
   return UNITY_END();
 }
@@ -11,7 +11,9 @@ void setUp() {
   lot = lot_from_file("../../test/test.lot");
 }
 
-void tearDown() {}
+void tearDown() {
+  free_lot(lot);
+}
 
 // === Test superpath_to_space ===
 void test_superpath_to_space_paths_connected(void) {
@@ -45,8 +47,51 @@ void test_superpath_to_space_paths_connected(void) {
   free(superpath);
 }
 
+void test_superpath_to_space_shortest_route(void) {
+  Space* space = space_by_name(lot, "C6");
+  if (!space) { TEST_FAIL_MESSAGE("Space C6 not found in lot"); }
+
+  int count = 0;
+  Path* superpath = superpath_to_space(lot, *space, &count);
+
+  // 3 paths to reach the level 1 crossing, then the subpath and the turnpath into C6
+  TEST_ASSERT_EQUAL_INT_MESSAGE(5, count, "Superpath should consist of 5 paths");
+  TEST_ASSERT_FLOAT_WITHIN_MESSAGE(0.001, 51.25, superpath_length(superpath, count),
+    "Superpath should be the shortest route to C6");
+
+  free(superpath);
+}
+
+void test_superpath_to_space_unreachable(void) {
+  Space far = { .type = Standard, .location = (Location){500, 500, 0}, .rotation = 0, .name = "far" };
+
+  int count = 0;
+  Path* superpath = superpath_to_space(lot, far, &count);
+
+  TEST_ASSERT_NULL_MESSAGE(superpath, "No superpath should exist to an inaccessible space");
+  TEST_ASSERT_EQUAL_INT_MESSAGE(-1, count, "Count should be -1 when no superpath exists");
+}
+
+void test_build_route_index(void) {
+  TEST_ASSERT_NOT_NULL_MESSAGE(lot.routes, "lot_from_file should build the route index");
+  TEST_ASSERT_EQUAL_INT_MESSAGE(lot.space_count, lot.routes->space_count, "There should be a route for every space");
+
+  int c6 = (int)(space_by_name(lot, "C6") - lot.spaces);
+  // 20 to the up, 30 for the ramp, then 10 + 13.25 + 8 on level 1
+  TEST_ASSERT_FLOAT_WITHIN_MESSAGE(0.001, 81.25, lot.routes->space_routes[c6].cost,
+    "Route cost to C6 should include the ramp");
+
+  int count = 0;
+  Path* indexed = superpath_to_space(lot, lot.spaces[c6], &count);
+  TEST_ASSERT_EQUAL_INT_MESSAGE(5, count, "Indexed superpath should consist of 5 paths");
+  free(indexed);
+}
+
 int main(void) {
   UNITY_BEGIN();
  	RUN_TEST(test_superpath_to_space_paths_connected);
+  RUN_TEST(test_superpath_to_space_shortest_route);
+  RUN_TEST(test_superpath_to_space_unreachable);
+  RUN_TEST(test_build_route_index);
   return UNITY_END();
 }
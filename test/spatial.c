@@ -0,0 +1,147 @@
+#include "unity.h"
+#include "spatial.h"
+#include "data.h"
+
+void setUp() {}
+
+void tearDown() {}
+
+// remembers every pair the grid hands out
+typedef struct {
+  int pairs[16][2];
+  int count;
+} PairLog;
+
+static int log_pairs(int a, const int *others, int count, void *context) {
+  PairLog *log = context;
+  for (int k = 0; k < count; k++) {
+    log->pairs[log->count][0] = a;
+    log->pairs[log->count][1] = others[k];
+    log->count++;
+  }
+  return 0;
+}
+
+static int stop_at_first_pair(int a, const int *others, int count, void *context) {
+  (void)a; (void)others; (void)count; (void)context;
+  return 7;
+}
+
+void test_aabbs_overlap(void) {
+  Aabb a = { {0, 0}, {2, 2} };
+  Aabb b = { {1, 1}, {3, 3} };
+  Aabb touching = { {2, 0}, {4, 2} };
+  Aabb apart = { {5, 5}, {6, 6} };
+  TEST_ASSERT_TRUE_MESSAGE(aabbs_overlap(a, b), "overlapping boxes should overlap");
+  TEST_ASSERT_TRUE_MESSAGE(aabbs_overlap(a, touching), "touching boxes count as overlapping");
+  TEST_ASSERT_FALSE_MESSAGE(aabbs_overlap(a, apart), "boxes far apart should not overlap");
+}
+
+void test_aabb_grid_pairs_each_pair_once(void) {
+  // 0 and 1 overlap across several cells, 2 is on its own and 3 touches 2
+  Aabb boxes[4] = {
+    { {0, 0}, {2.5, 5} },
+    { {2, 1}, {4.5, 6} },
+    { {20, 20}, {22.5, 25} },
+    { {22.5, 20}, {25, 25} }
+  };
+  AabbGrid grid = build_aabb_grid(boxes, 4);
+  PairLog log = {0};
+  TEST_ASSERT_EQUAL_INT(0, aabb_grid_pairs(&grid, boxes, log_pairs, &log));
+  TEST_ASSERT_EQUAL_INT_MESSAGE(2, log.count, "exactly the two overlapping pairs should be visited");
+  for (int i = 0; i < log.count; i++) {
+    int a = log.pairs[i][0], b = log.pairs[i][1];
+    int expected = (a == 0 && b == 1) || (a == 1 && b == 0) || (a == 2 && b == 3) || (a == 3 && b == 2);
+    TEST_ASSERT_TRUE_MESSAGE(expected, "only overlapping boxes should be paired");
+  }
+  free_aabb_grid(grid);
+}
+
+void test_aabb_grid_pairs_stops_early(void) {
+  Aabb boxes[2] = { { {0, 0}, {1, 1} }, { {0.5, 0.5}, {1.5, 1.5} } };
+  AabbGrid grid = build_aabb_grid(boxes, 2);
+  TEST_ASSERT_EQUAL_INT_MESSAGE(7, aabb_grid_pairs(&grid, boxes, stop_at_first_pair, NULL), "the result of visit should be passed on");
+  free_aabb_grid(grid);
+}
+
+// pairs sharing several cells, and pairs sharing cells whose boxes don't overlap, are still counted once
+void test_aabb_grid_pairs_stats(void) {
+  // 0 and 1 overlap and share all four of their cells, 2 sits in a corner cell with both of them
+  // and 3 shares two cells with them while staying just to their right
+  Aabb boxes[4] = {
+    { {1, 1}, {3, 3} },
+    { {1.5, 1.5}, {3.5, 3.5} },
+    { {0, 0}, {0.5, 0.5} },
+    { {3.6, 1}, {5.6, 3} }
+  };
+  AabbGrid grid = build_aabb_grid(boxes, 4);
+  TEST_ASSERT_EQUAL_DOUBLE_MESSAGE(2.0, grid.cell_size, "the layout relies on cells as large as the boxes");
+  reset_aabb_stats();
+  PairLog log = {0};
+  TEST_ASSERT_EQUAL_INT(0, aabb_grid_pairs(&grid, boxes, log_pairs, &log));
+  TEST_ASSERT_EQUAL_INT(1, log.count);
+  AabbStats stats = aabb_stats();
+  TEST_ASSERT_EQUAL_INT_MESSAGE(1, (int)stats.hits, "only 0 and 1 go on to SAT, and only once");
+  TEST_ASSERT_EQUAL_INT_MESSAGE(4, (int)stats.misses, "0 and 1 are each thrown out once against 2 and once against 3");
+  free_aabb_grid(grid);
+}
+
+static int count_item(int item, void *context) {
+  (void)item;
+  (*(int *)context)++;
+  return 0;
+}
+
+static int stop_at_first_item(int item, void *context) {
+  (void)item; (void)context;
+  return 7;
+}
+
+void test_aabb_tree_query(void) {
+  // a row of 20 unit boxes, one every 2 units
+  Aabb boxes[20];
+  int items[20];
+  for (int i = 0; i < 20; i++) {
+    boxes[i] = (Aabb){ {2.0 * i, 0}, {2.0 * i + 1, 1} };
+    items[i] = i;
+  }
+  AabbTree tree = build_aabb_tree(boxes, items, 20);
+  reset_aabb_stats();
+
+  int found = 0;
+  aabb_tree_query(&tree, boxes, (Aabb){ {4.5, 0.5}, {8.5, 0.6} }, count_item, &found);
+  TEST_ASSERT_EQUAL_INT_MESSAGE(3, found, "the query should find boxes 2, 3 and 4 only");
+  AabbStats stats = aabb_stats();
+  TEST_ASSERT_EQUAL_INT_MESSAGE(3, (int)stats.hits, "every box the query found is a hit");
+  TEST_ASSERT_EQUAL_INT_MESSAGE(17, (int)stats.misses, "every box the query did not find was rejected");
+
+  reset_aabb_stats();
+  found = 0;
+  aabb_tree_query(&tree, boxes, (Aabb){ {0, 5}, {40, 6} }, count_item, &found);
+  TEST_ASSERT_EQUAL_INT_MESSAGE(0, found, "nothing lies above the row");
+  stats = aabb_stats();
+  TEST_ASSERT_EQUAL_INT(0, (int)stats.hits);
+  TEST_ASSERT_EQUAL_INT_MESSAGE(20, (int)stats.misses, "the root throws out every box at once");
+
+  // stopping at the first box only counts that box
+  reset_aabb_stats();
+  TEST_ASSERT_EQUAL_INT(7, aabb_tree_query(&tree, boxes, (Aabb){ {-1, -1}, {41, 2} }, stop_at_first_item, NULL));
+  stats = aabb_stats();
+  TEST_ASSERT_EQUAL_INT(1, (int)stats.hits);
+  TEST_ASSERT_EQUAL_INT(0, (int)stats.misses);
+
+  found = 0;
+  aabb_tree_query(&tree, boxes, (Aabb){ {-1, -1}, {41, 2} }, count_item, &found);
+  TEST_ASSERT_EQUAL_INT_MESSAGE(20, found, "a query over everything should find every box once");
+  free_aabb_tree(tree);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_aabbs_overlap);
+  RUN_TEST(test_aabb_grid_pairs_each_pair_once);
+  RUN_TEST(test_aabb_grid_pairs_stops_early);
+  RUN_TEST(test_aabb_grid_pairs_stats);
+  RUN_TEST(test_aabb_tree_query);
+  return UNITY_END();
+}
@@ -0,0 +1,47 @@
+#include "unity.h"
+#include "threadPool.h"
+#include <stdatomic.h>
+
+void setUp() {}
+
+void tearDown() {}
+
+static atomic_int counter;
+
+static void count_task(void *argument) {
+  atomic_fetch_add(&counter, *(int *)argument);
+}
+
+void test_thread_pool_runs_every_task(void) {
+  ThreadPool *pool = create_thread_pool(4);
+  TEST_ASSERT_EQUAL_INT(4, thread_pool_size(pool));
+
+  int amounts[1000];
+  atomic_store(&counter, 0);
+  for (int i = 0; i < 1000; i++) {
+    amounts[i] = i;
+    thread_pool_submit(pool, count_task, &amounts[i]);
+  }
+  thread_pool_wait(pool);
+  TEST_ASSERT_EQUAL_INT_MESSAGE(999 * 1000 / 2, atomic_load(&counter), "every task should have run exactly once");
+
+  // the pool can be used again after waiting
+  thread_pool_submit(pool, count_task, &amounts[7]);
+  thread_pool_wait(pool);
+  TEST_ASSERT_EQUAL_INT(999 * 1000 / 2 + 7, atomic_load(&counter));
+  free_thread_pool(pool);
+}
+
+void test_thread_pool_default_size(void) {
+  ThreadPool *pool = create_thread_pool(0);
+  TEST_ASSERT_TRUE_MESSAGE(thread_pool_size(pool) >= 1, "a default pool should have at least one worker");
+  thread_pool_wait(pool); // nothing submitted, should return right away
+  free_thread_pool(pool);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_thread_pool_runs_every_task);
+  RUN_TEST(test_thread_pool_default_size);
+  return UNITY_END();
+}
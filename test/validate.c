@@ -2,16 +2,36 @@
 #include "validate.h"
 #include "lot.h"
 #include "data.h"
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
+static ThreadPool *pool;
+
 void setUp() {}
 
 void tearDown() {}
 
+// every validation in here also runs in parallel, which must give the same result
+static ValidationResult validate_both_ways(const Lot lot) {
+  ValidationResult sequential = validate_lot(lot);
+  ValidationTiming timing;
+  ValidationResult parallel = validate_lot_parallel(lot, pool, &timing);
+  TEST_ASSERT_EQUAL_INT_MESSAGE(sequential.result, parallel.result, "parallel validation should give the same result");
+  TEST_ASSERT_EQUAL_INT_MESSAGE(sequential.error, parallel.error, "parallel validation should give the same error");
+  TEST_ASSERT_TRUE_MESSAGE(timing.total_ms >= 0.0, "parallel validation should report its timing");
+  ValidationReport report = validate_lot_report(lot);
+  ValidationResult reported = validation_report_result(report);
+  free_validation_report(report);
+  TEST_ASSERT_EQUAL_INT_MESSAGE(sequential.result, reported.result, "the report should agree with validate_lot");
+  TEST_ASSERT_EQUAL_INT_MESSAGE(sequential.error, reported.error, "the first issue in the report should be the error validate_lot gives");
+  return sequential;
+}
+
 // Helper macro for asserting ValidationResult
 // This gives us nice error messages showing exactly which error occurred
 #define TEST_ASSERT_VALIDATION_OK(lot) do { \
-  ValidationResult _res = validate_lot(lot); \
+  ValidationResult _res = validate_both_ways(lot); \
   if (_res.result != Ok) { \
     char _msg[256]; \
     snprintf(_msg, sizeof(_msg), "Expected Ok but got error: %s", validation_error_message(_res.error)); \
@@ -20,7 +40,7 @@ void tearDown() {}
 } while(0)
 
 #define TEST_ASSERT_VALIDATION_ERR(expected_error, lot) do { \
-  ValidationResult _res = validate_lot(lot); \
+  ValidationResult _res = validate_both_ways(lot); \
   if (_res.result != Err) { \
     TEST_FAIL_MESSAGE("Expected Err but got Ok"); \
   } else if (_res.error != expected_error) { \
@@ -57,6 +77,20 @@ void test_paths_connected() {
   free_lot(lot);
 }
 
+void test_paths_connected_despite_rounding() {
+  Lot lot = create_lot(1, 2, 0, 0, 0);
+  lot.entrance = (Location){0, 0.1, 0};
+  lot.POI = (Location){0, 0.1, 0};
+  lot.paths[0] = (Path){ .start_point = (Location){0, 0.1, 0}, .vector = (Vector){0.1, 0.2} };
+  // 0.1 + 0.2 is not exactly 0.3 in floating point, but they are the same place in the lot
+  lot.paths[1] = (Path){ .start_point = (Location){0.1, 0.3, 0}, .vector = (Vector){5, 0} };
+  TEST_ASSERT_EQUAL_INT_MESSAGE(1, paths_connected(lot), "locations a rounding error apart should connect");
+
+  lot.paths[1].start_point.y = 0.31;
+  TEST_ASSERT_EQUAL_INT_MESSAGE(0, paths_connected(lot), "locations a centimetre apart should not connect");
+  free_lot(lot);
+}
+
 // === Rule 2: No spaces may overlap ===
 
 void test_spaces_overlap() {
@@ -118,6 +152,27 @@ void test_spaces_accessible() {
   free_lot(lot);
 }
 
+void test_corridors_touching_space() {
+  Lot lot = create_lot(2, 4, 1, 0, 0);
+  lot.paths[0] = (Path){ .start_point = (Location){20, 0, 0}, .vector = (Vector){0, 20} };
+  lot.paths[1] = (Path){ .start_point = (Location){0, 0, 0}, .vector = (Vector){20, 0} };
+  lot.paths[2] = (Path){ .start_point = (Location){0, 40, 0}, .vector = (Vector){20, 0} };
+  lot.paths[3] = (Path){ .start_point = (Location){0, 0, 1}, .vector = (Vector){20, 0} };
+  // close to the corner where paths 0 and 1 meet
+  lot.spaces[0] = (Space){ .type = Standard, .location = (Location){16, 3, 0}, .rotation = 0.0, .name = "corner" };
+
+  CorridorIndex *index = build_corridor_index(lot, 6.0);
+  SpaceGeometry space = get_space_geometry(lot.spaces[0]);
+  int paths[4];
+  TEST_ASSERT_EQUAL_INT_MESSAGE(2, corridors_touching_space(index, &space, 0, paths), "only the two nearby paths on level 0 should touch the space");
+  TEST_ASSERT_EQUAL_INT_MESSAGE(0, paths[0], "paths should come back in lot order");
+  TEST_ASSERT_EQUAL_INT_MESSAGE(1, paths[1], "paths should come back in lot order");
+  TEST_ASSERT_EQUAL_INT_MESSAGE(1, corridors_touching_space(index, &space, 1, NULL), "the path on level 1 should touch the space on level 1");
+  TEST_ASSERT_EQUAL_INT_MESSAGE(0, corridors_touching_space(index, &space, 5, NULL), "a level without paths has no corridors");
+  free_corridor_index(index);
+  free_lot(lot);
+}
+
 // === Rule 5: Valid entrance and POI ===
 
 void test_has_valid_entrance_and_poi() {
@@ -176,6 +231,22 @@ void test_spaces_have_unique_names_empty() {
   free_lot(lot);
 }
 
+void test_spaces_have_unique_names_many() {
+  Lot lot = create_lot(1, 1, 5000, 0, 0);
+  lot.paths[0] = (Path){ .start_point = (Location){0, 0, 0}, .vector = (Vector){10, 0} };
+  char (*names)[8] = malloc(sizeof(*names) * 5000);
+  for (int i = 0; i < 5000; i++) {
+    snprintf(names[i], sizeof(names[i]), "S%d", i);
+    lot.spaces[i] = (Space){ .type = Standard, .location = (Location){i, 3, 0}, .rotation = 0, .name = names[i] };
+  }
+  TEST_ASSERT_EQUAL_INT_MESSAGE(1, spaces_have_unique_names(lot), "all names should be unique");
+
+  lot.spaces[4999].name = names[1234];
+  TEST_ASSERT_EQUAL_INT_MESSAGE(0, spaces_have_unique_names(lot), "the last space reuses a name");
+  free(names);
+  free_lot(lot);
+}
+
 void test_spaces_have_unique_names_single() {
   Lot lot = create_lot(1, 1, 1, 0, 0);
   lot.paths[0] = (Path){ .start_point = (Location){0, 0, 0}, .vector = (Vector){10, 0} };
@@ -485,16 +556,58 @@ void test_validate_lot_no_spaces() {
   free_lot(lot);
 }
 
+// the report should keep going past the first failure and name the spaces and paths involved
+void test_validate_lot_report_collects_every_issue() {
+  Lot lot = create_lot(1, 2, 4, 0, 0);
+  lot.entrance = (Location){0, 0, 0};
+  lot.POI = (Location){10, 0, 3}; // no level 3
+  lot.paths[0] = (Path){ .start_point = (Location){0, 0, 0}, .vector = (Vector){20, 0} };
+  lot.paths[1] = (Path){ .start_point = (Location){50, 50, 0}, .vector = (Vector){10, 0} }; // orphan
+
+  lot.spaces[0] = (Space){ .type = Standard, .location = (Location){5, 4, 0}, .rotation = 0, .name = "A1" };
+  lot.spaces[1] = (Space){ .type = Standard, .location = (Location){5, 4, 0}, .rotation = 0, .name = "A1" };
+  lot.spaces[2] = (Space){ .type = Standard, .location = (Location){15, 0, 0}, .rotation = 0, .name = "MUCHTOOLONG" };
+  lot.spaces[3] = (Space){ .type = Standard, .location = (Location){100, 100, 0}, .rotation = 0, .name = "C1" };
+
+  ValidationReport report = validate_lot_report(lot);
+  ValidationIssue expected[] = {
+    { PathNotConnected, -1, -1, 1, 0 },
+    { SpacesOverlap, 0, 1, -1, 0 },
+    { SpacesEncroachPath, 2, -1, 0, 0 },
+    { SpacesInaccessible, 3, -1, -1, 0 },
+    { InvalidEntranceOrPOI, -1, -1, -1, 3 },
+    { DuplicateSpaceNames, 1, 0, -1, 0 },
+    { SpaceNameTooLong, 2, -1, -1, 0 }
+  };
+  int expected_count = sizeof(expected) / sizeof(expected[0]);
+  TEST_ASSERT_EQUAL_INT(expected_count, report.issue_count);
+  for (int i = 0; i < expected_count; i++) {
+    TEST_ASSERT_EQUAL_INT(expected[i].error, report.issues[i].error);
+    TEST_ASSERT_EQUAL_INT(expected[i].space, report.issues[i].space);
+    TEST_ASSERT_EQUAL_INT(expected[i].other_space, report.issues[i].other_space);
+    TEST_ASSERT_EQUAL_INT(expected[i].path, report.issues[i].path);
+    TEST_ASSERT_EQUAL_INT(expected[i].level, report.issues[i].level);
+  }
+  TEST_ASSERT_VALIDATION_ERR(PathNotConnected, lot);
+
+  free_validation_report(report);
+  free_lot(lot);
+}
+
 int main(void) {
+  pool = create_thread_pool(4);
   UNITY_BEGIN();
   RUN_TEST(test_paths_connected);
+  RUN_TEST(test_paths_connected_despite_rounding);
   RUN_TEST(test_spaces_overlap);
   RUN_TEST(test_spaces_encroach_path);
   RUN_TEST(test_spaces_accessible);
+  RUN_TEST(test_corridors_touching_space);
   RUN_TEST(test_has_valid_entrance_and_poi);
   RUN_TEST(test_spaces_have_unique_names);
   RUN_TEST(test_spaces_have_unique_names_empty);
   RUN_TEST(test_spaces_have_unique_names_single);
+  RUN_TEST(test_spaces_have_unique_names_many);
   RUN_TEST(test_has_correct_up_down_count_single_level);
   RUN_TEST(test_has_correct_up_down_count_two_levels);
   RUN_TEST(test_has_correct_up_down_count_three_levels);
@@ -519,5 +632,8 @@ int main(void) {
   RUN_TEST(test_validate_lot_wrong_up_down_count);
   RUN_TEST(test_validate_lot_ups_downs_on_wrong_levels);
   RUN_TEST(test_validate_lot_no_spaces);
-  return UNITY_END();
+  RUN_TEST(test_validate_lot_report_collects_every_issue);
+  int failures = UNITY_END();
+  free_thread_pool(pool);
+  return failures;
 }